@@ -0,0 +1,87 @@
+// Heap allocations on the interactive paths: toggling a habit while the UI
+// holds a snapshot, rebuilding one frame of the habit list and looking a
+// habit up by name. "allocs_per_op" is operator new calls per operation.
+
+#include "Bench.h"
+#include "Analytics.h"
+#include "HabitManager.h"
+#include <algorithm>
+
+using namespace bench;
+
+namespace {
+
+constexpr int kVisibleRows = 40;
+
+// names of realistic length, past the small-string buffer
+std::vector<std::string> habitNames(int n) {
+    std::vector<std::string> names;
+    names.reserve(n);
+    for (int i = 0; i < n; ++i) names.push_back("habit " + std::to_string(i) + " - read before bed");
+    return names;
+}
+
+template <typename F>
+Result countAllocs(std::string name, std::uint64_t ops, F&& f) {
+    Result r{std::move(name), ops};
+    std::uint64_t before = Heap::allocs.load();
+    r.seconds = seconds(f);
+    r.extra["allocs_per_op"] = static_cast<double>(Heap::allocs.load() - before) / static_cast<double>(ops);
+    return r;
+}
+
+} // namespace
+
+HABIT_BENCH(alloc_paths) {
+    int n = std::min(cfg.habits, 1000);
+    std::vector<std::string> names = habitNames(n);
+    HabitManager manager;
+    for (const auto& name : names) manager.addHabit(name);
+    HabitManager::Reader reader(manager);
+    date::Day today = date::today();
+
+    // the UI re-reads after every toggle, so each one copies what it edits
+    const std::uint64_t toggles = 100000;
+    out.push_back(countAllocs("alloc_toggle", toggles, [&] {
+        for (std::uint64_t i = 0; i < toggles; ++i) {
+            manager.setToday(names[i % n], i / n % 2 == 0);
+            keep(reader.get());
+        }
+    }));
+    out.push_back(countAllocs("alloc_toggle_handle", toggles, [&] {
+        for (std::uint64_t i = 0; i < toggles; ++i) {
+            const HabitSnapshot& habits = reader.get();
+            manager.setToday(habits.handle(i % n), i / n % 2 == 0);
+        }
+    }));
+
+    // what the renderer builds for a frame in which every visible row and
+    // the 7-day panel changed (FTXUI's own Elements not included)
+    const std::uint64_t frames = 20000;
+    out.push_back(countAllocs("alloc_frame_rebuild", frames, [&] {
+        for (std::uint64_t f = 0; f < frames; ++f) {
+            const HabitSnapshot& habits = reader.get();
+            std::size_t top = f * kVisibleRows % habits.size();
+            std::size_t end = std::min(habits.size(), top + kVisibleRows);
+            for (std::size_t i = top; i < end; ++i) {
+                const Habit& h = habits[i];
+                std::string label = " ";
+                label += h.getName();
+                std::string streak = "  (streak: " + std::to_string(h.currentStreak(today)) + ")";
+                keep(label);
+                keep(streak);
+            }
+            const Habit& selected = habits[top];
+            HabitStats month = habitStats(selected, today - 29, today);
+            std::string title = " Weekly (last 7 days) for: ";
+            title += selected.getName();
+            keep(month);
+            keep(title);
+        }
+    }));
+
+    const std::uint64_t lookups = 200000;
+    out.push_back(countAllocs("alloc_lookup", lookups, [&] {
+        for (std::uint64_t i = 0; i < lookups; ++i) keep(manager.find(names[i % n]));
+    }));
+}
@@ -0,0 +1,92 @@
+// Backfilling and clearing history: a year of past days set one call at a
+// time against one range call, in memory and through SQLite, and a range
+// cleared out of the middle of a long streak (the longest-streak rescan).
+
+#include "Bench.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include <algorithm>
+
+using namespace bench;
+
+namespace {
+
+constexpr int kYear = 365;
+
+} // namespace
+
+HABIT_BENCH(backfill_memory) {
+    int n = std::min(cfg.habits, 1000);
+    date::Day today = date::today();
+
+    for (bool range : {false, true}) {
+        std::vector<Habit> habits;
+        for (int i = 0; i < n; ++i) habits.emplace_back("habit " + std::to_string(i));
+        Result r{range ? "backfill_memory_range" : "backfill_memory_per_day",
+                 static_cast<std::uint64_t>(n) * kYear};
+        r.seconds = seconds([&] {
+            for (auto& h : habits) {
+                if (range) h.setCompletedRange(today - kYear + 1, today, true);
+                else for (date::Day d = today - kYear + 1; d <= today; ++d) h.setCompletedOn(d, true);
+            }
+        });
+        keep(habits.front().longestStreak());
+        out.push_back(r);
+    }
+}
+
+HABIT_BENCH(backfill_sqlite) {
+    int n = std::min(cfg.habits, 100);
+    date::Day today = date::today();
+
+    // per_day: one transaction per day; per_day_batched: the same calls in a
+    // batch; range: one call (and one transaction) per habit
+    for (const char* mode : {"per_day", "per_day_batched", "range"}) {
+        std::string path = cfg.dir + "/bench_backfill.db";
+        removeDB(path);
+        HabitManager manager;
+        manager.openDB(path);
+        for (int i = 0; i < n; ++i) manager.addHabit("habit " + std::to_string(i));
+        HabitSnapshot habits = manager.getHabits();
+
+        std::string name = mode;
+        int count = name == "per_day" ? std::min(n, 5) : n;   // a commit per day is slow
+        Result r{"backfill_sqlite_" + name, static_cast<std::uint64_t>(count) * kYear};
+        r.seconds = seconds([&] {
+            if (name == "per_day_batched") manager.beginBatch(kYear * count, std::chrono::hours(1));
+            for (int i = 0; i < count; ++i) {
+                HabitHandle h = habits.handle(i);
+                if (name == "range") manager.setCompletedRange(h, today - kYear + 1, today, true);
+                else for (date::Day d = today - kYear + 1; d <= today; ++d) manager.setCompletedOn(h, d, true);
+            }
+            if (name == "per_day_batched") manager.endBatch();
+        });
+        out.push_back(r);
+        removeDB(path);
+    }
+}
+
+// Each round clears a week in the middle of a long streak (so the longest
+// run is cut and rescanned once) and sets it back.
+HABIT_BENCH(backfill_clear_middle) {
+    const int days = 10 * kYear;
+    const int rounds = 2000;
+    for (bool range : {false, true}) {
+        Habit h = std::move(generateStreaks(1, days).front());
+        date::Day mid = date::today() - days / 2;
+        Result r{range ? "backfill_clear_middle_range" : "backfill_clear_middle_per_day",
+                 static_cast<std::uint64_t>(rounds) * 7};
+        r.seconds = seconds([&] {
+            for (int i = 0; i < rounds; ++i) {
+                if (range) {
+                    h.setCompletedRange(mid, mid + 6, false);
+                } else {
+                    for (date::Day d = mid; d <= mid + 6; ++d) h.setCompletedOn(d, false);
+                }
+                h.setCompletedRange(mid, mid + 6, true);
+            }
+        });
+        r.extra["longest"] = h.longestStreak();
+        out.push_back(r);
+    }
+}
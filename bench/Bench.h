@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Small harness for habit_bench: timing, heap accounting and result records.
+
+namespace bench {
+
+struct Config {
+    int habits = 1000;
+    int years = 3;
+    double density = 0.7;         // chance a given day is completed
+    unsigned seed = 42;
+    std::string dir = "bench_data";
+    std::string filter;           // run only benchmarks whose name contains this
+    int importMB = 64;            // size of the generated bulk-import files
+    std::string tracker;          // habit_tracker binary for the process-level CLI benches
+};
+
+struct Result {
+    Result(std::string n, std::uint64_t o = 0) : name(std::move(n)), ops(o) {}
+
+    std::string name;
+    std::uint64_t ops = 0;
+    double seconds = 0.0;
+    std::map<std::string, double> extra;   // bench-specific metrics
+
+    double nsPerOp() const { return ops ? seconds * 1e9 / static_cast<double>(ops) : 0.0; }
+    double opsPerSec() const { return seconds > 0 ? static_cast<double>(ops) / seconds : 0.0; }
+};
+
+// Heap accounting from the counting operator new/delete in habit_bench.cpp.
+struct Heap {
+    static std::atomic<std::uint64_t> allocs;
+    static std::atomic<std::int64_t> live;
+    static std::atomic<std::int64_t> peak;
+
+    static void resetPeak() { peak = live.load(); }
+};
+
+template <typename F>
+double seconds(F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// keep the optimizer from discarding a computed value
+template <typename T>
+inline void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+using Fn = std::function<void(const Config&, std::vector<Result>&)>;
+
+struct Registry {
+    static std::vector<std::pair<std::string, Fn>>& all();
+};
+
+struct Register {
+    Register(const char* name, Fn fn) { Registry::all().emplace_back(name, std::move(fn)); }
+};
+
+} // namespace bench
+
+#define HABIT_BENCH(name) \
+    static void name(const bench::Config&, std::vector<bench::Result>&); \
+    static bench::Register reg_##name(#name, name); \
+    static void name([[maybe_unused]] const bench::Config& cfg, std::vector<bench::Result>& out)
@@ -0,0 +1,126 @@
+// Headless command mode: commands per second inside one process, and the
+// startup-to-exit latency of the habit_tracker binary (launched directly,
+// stdout to /dev/null). The process benches need --tracker PATH (set by the
+// CMake build) and are skipped without it.
+
+#include "Bench.h"
+#include "Cli.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <spawn.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+using namespace bench;
+
+namespace {
+
+std::string copyDataset(const Config& cfg, const std::string& name) {
+    ensureDataset(cfg);
+    std::string path = cfg.dir + "/" + name;
+    removeDB(path);
+    std::filesystem::copy_file(datasetDB(cfg), path);
+    return path;
+}
+
+std::string smallDB(const Config& cfg, int habits) {
+    std::string path = cfg.dir + "/bench_cli_small.db";
+    removeDB(path);
+    HabitManager manager;
+    manager.openDB(path);
+    for (int i = 0; i < habits; ++i) manager.addHabit("habit " + std::to_string(i));
+    return path;
+}
+
+// `count` mark commands spread over habits and the past year
+std::string markScript(std::size_t count, int habits) {
+    std::string script;
+    date::Day today = date::today();
+    for (std::size_t i = 0; i < count; ++i)
+        script += "mark --habit \"habit " + std::to_string(i % habits) + "\" --date " +
+                  date::toISO(today - static_cast<date::Day>(i / habits % 365)) + "\n";
+    return script;
+}
+
+// run the tracker with args, stdout discarded; true if it exited with 0
+bool launch(const std::string& bin, std::vector<std::string> args) {
+    args.insert(args.begin(), bin);
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    int rc = posix_spawn(&pid, bin.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    int status = 0;
+    return rc == 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+// open + load + commands + commit, as one batch invocation does it
+HABIT_BENCH(cli_batch) {
+    const std::size_t n = 20000;
+    auto batch = [&](const std::string& name, const std::string& path, int habits) {
+        std::istringstream in(markScript(n, habits));
+        std::ostringstream lines;
+        Result r{name, n};
+        int code = 0;
+        r.seconds = seconds([&] { code = cli::run({"batch", "--db", path}, in, lines); });
+        r.extra["exit_code"] = code;
+        out.push_back(r);
+    };
+    batch("cli_batch_inproc_small", smallDB(cfg, 10), 10);
+    batch("cli_batch_inproc_dataset", copyDataset(cfg, "bench_cli.db"), std::min(cfg.habits, 1000));
+}
+
+HABIT_BENCH(cli_process) {
+    if (cfg.tracker.empty() || access(cfg.tracker.c_str(), X_OK) != 0) {
+        std::cerr << "cli_process: no habit_tracker binary (--tracker PATH), skipped\n";
+        return;
+    }
+    const std::string& bin = cfg.tracker;
+    std::string small = smallDB(cfg, 10);
+    std::string dataset = copyDataset(cfg, "bench_cli.db");
+    double failures = 0;
+
+    auto launches = [&](const std::string& name, int runs, const std::vector<std::string>& args) {
+        Result r{name, static_cast<std::uint64_t>(runs)};
+        r.seconds = seconds([&] { for (int i = 0; i < runs; ++i) failures += !launch(bin, args); });
+        r.extra["ms_per_launch"] = r.seconds * 1e3 / runs;
+        out.push_back(r);
+    };
+    launches("cli_startup_small", 50, {"list", "--db", small});
+    launches("cli_startup_dataset", 5, {"list", "--db", dataset});
+
+    // the nightly-script shape: one launch per operation vs one piped batch
+    const int ops = 100;
+    Result perOp{"cli_launch_per_op", ops};
+    perOp.seconds = seconds([&] {
+        for (int i = 0; i < ops; ++i)
+            failures += !launch(bin, {"mark", "--habit", "habit " + std::to_string(i % 10), "--db", small});
+    });
+    out.push_back(perOp);
+
+    const std::size_t piped = 20000;
+    std::string script = markScript(piped, 10);
+    Result batch{"cli_batch_pipe", piped};
+    batch.seconds = seconds([&] {
+        FILE* p = popen((bin + " batch --db " + small + " > /dev/null").c_str(), "w");
+        if (!p) { ++failures; return; }
+        std::fwrite(script.data(), 1, script.size(), p);
+        failures += pclose(p) != 0;
+    });
+    out.push_back(batch);
+    out.back().extra["failures"] = failures;
+}
@@ -0,0 +1,97 @@
+// Readers on snapshots while a writer toggles and adds habits. Every reader
+// checks each version it sees for internal consistency; any inconsistency is
+// reported in the "errors" extra; habit_bench exits with 3 if it is not 0.
+
+#include "Bench.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include <atomic>
+#include <random>
+#include <thread>
+
+using namespace bench;
+
+namespace {
+
+struct ReadLoad {
+    std::atomic<std::uint64_t> reads{0};
+    std::atomic<std::uint64_t> errors{0};
+};
+
+// a slot's habit is found under its own name, sizes never shrink and a
+// habit's revision never goes back while the generation stays the same
+void readLoop(HabitManager& manager, const std::atomic<bool>& stop, ReadLoad& load, unsigned seed) {
+    HabitManager::Reader reader(manager);
+    std::mt19937 rng(seed);
+    date::Day today = date::today();
+    std::size_t lastSize = 0;
+    std::vector<std::uint32_t> lastRevision;
+    std::uint64_t reads = 0, errors = 0;
+    long long sink = 0;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        const HabitSnapshot& snap = reader.get();
+        if (snap.empty()) continue;
+        errors += snap.size() < lastSize;
+        lastSize = snap.size();
+        if (lastRevision.size() < snap.size()) lastRevision.resize(snap.size(), 0);
+
+        for (int k = 0; k < 64; ++k) {
+            std::size_t i = rng() % snap.size();
+            const Habit& h = snap[i];
+            errors += snap.find(h.getName()) != &h;
+            errors += h.revision() < lastRevision[i];
+            lastRevision[i] = h.revision();
+            sink += h.currentStreak(today) + h.isCompletedOn(today);
+        }
+        reads += 64;
+    }
+    keep(sink);
+    load.reads += reads;
+    load.errors += errors;
+}
+
+} // namespace
+
+HABIT_BENCH(concurrent_readers) {
+    Config small = cfg;
+    small.habits = std::min(cfg.habits, 1000);
+    small.years = 1;
+    const auto duration = std::chrono::milliseconds(500);
+
+    for (unsigned readers : {1u, 2u, 4u, 8u}) {
+        for (bool withWriter : {false, true}) {
+            HabitManager manager;
+            manager.addHabits(generateHabits(small));
+
+            std::atomic<bool> stop{false};
+            ReadLoad load;
+            std::vector<std::thread> threads;
+            for (unsigned r = 0; r < readers; ++r)
+                threads.emplace_back(readLoop, std::ref(manager), std::cref(stop), std::ref(load), cfg.seed + r);
+
+            std::uint64_t writes = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            if (withWriter) {
+                std::mt19937 rng(cfg.seed);
+                while (std::chrono::steady_clock::now() - t0 < duration) {
+                    std::string name = "habit " + std::to_string(rng() % small.habits);
+                    manager.setToday(name, rng() % 2);
+                    if (++writes % 1000 == 0) manager.addHabit(Habit("extra " + std::to_string(writes)));
+                }
+            } else {
+                std::this_thread::sleep_for(duration);
+            }
+            stop = true;
+            for (auto& t : threads) t.join();
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+            Result r{"concurrent_readers_" + std::to_string(readers) + (withWriter ? "_writer" : ""),
+                     load.reads.load()};
+            r.seconds = secs;
+            r.extra["writes_per_sec"] = static_cast<double>(writes) / secs;
+            r.extra["errors"] = static_cast<double>(load.errors.load());
+            out.push_back(r);
+        }
+    }
+}
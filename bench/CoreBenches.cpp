@@ -0,0 +1,330 @@
+// Benchmarks for Habit, the date module, HabitManager persistence and
+// analytics. Where a path was rewritten, the old implementation is kept
+// here ("legacy") so both can be compared in the same run.
+
+#include "Bench.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include "HabitJson.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+
+using namespace bench;
+using nlohmann::json;
+
+namespace {
+
+// ----------------- Legacy layout -----------------
+// std::set<std::string> of "YYYY-MM-DD" plus the localtime/strftime streak walk.
+
+std::string legacyTodayISO(std::chrono::system_clock::time_point t) {
+    std::time_t tt = std::chrono::system_clock::to_time_t(t);
+    std::tm tm = *std::localtime(&tt);
+    char buf[11];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return std::string(buf);
+}
+
+struct LegacyHabit {
+    std::set<std::string> dates;
+
+    explicit LegacyHabit(const Habit& h) {
+        h.completions().forEach([&](date::Day d) { dates.insert(date::toISO(d)); });
+    }
+    int currentStreak() const {
+        int streak = 0;
+        auto day = std::chrono::system_clock::now();
+        while (dates.count(legacyTodayISO(day))) {
+            ++streak;
+            day -= std::chrono::hours(24);
+        }
+        return streak;
+    }
+};
+
+std::int64_t fileSize(const std::string& path) {
+    std::error_code ec;
+    auto n = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<std::int64_t>(n);
+}
+
+} // namespace
+
+// ----------------- Habit -----------------
+
+// Bitmap words come from the pool, whose slabs and free lists Heap::live
+// cannot attribute to a habit (and which earlier benchmarks leave warm), so
+// the bitmap side is counted from the layout: words held plus the Habit.
+HABIT_BENCH(bitmap_memory) {
+    Result r{"bitmap_memory"};
+    std::vector<Habit> habits;
+    r.seconds = seconds([&] { habits = generateHabits(cfg); });
+    r.ops = habits.size();
+    std::int64_t wordBytes = 0;
+    for (const auto& h : habits) wordBytes += static_cast<std::int64_t>(h.completions().memoryBytes());
+    std::int64_t bitmapBytes = wordBytes + static_cast<std::int64_t>(habits.size() * sizeof(Habit));
+
+    std::int64_t before = Heap::live;
+    std::vector<LegacyHabit> legacy;
+    legacy.reserve(habits.size());
+    for (const auto& h : habits) legacy.emplace_back(h);
+    std::int64_t setBytes = Heap::live - before;
+
+    double habitYears = static_cast<double>(cfg.habits) * cfg.years;
+    r.extra["bytes_per_habit_year"] = bitmapBytes / habitYears;
+    r.extra["word_bytes_per_habit_year"] = wordBytes / habitYears;
+    r.extra["legacy_bytes_per_habit_year"] = setBytes / habitYears;
+    out.push_back(r);
+}
+
+HABIT_BENCH(is_completed_on) {
+    std::vector<Habit> habits = generateHabits(cfg);
+    date::Day today = date::today();
+    int span = 365 * cfg.years;
+    std::mt19937 rng(cfg.seed);
+    const std::size_t kQueries = 2000000;
+    std::vector<std::pair<std::uint32_t, date::Day>> queries(kQueries);
+    for (auto& q : queries)
+        q = {static_cast<std::uint32_t>(rng() % habits.size()), today - static_cast<date::Day>(rng() % span)};
+
+    Result r{"is_completed_on", kQueries};
+    std::size_t hits = 0;
+    r.seconds = seconds([&] {
+        for (const auto& q : queries) hits += habits[q.first].isCompletedOn(q.second);
+    });
+    keep(hits);
+    out.push_back(r);
+
+    // legacy: string keys, pre-formatted so only the lookup is timed
+    std::vector<LegacyHabit> legacy;
+    legacy.reserve(habits.size());
+    for (const auto& h : habits) legacy.emplace_back(h);
+    std::vector<std::string> iso(static_cast<std::size_t>(span));
+    for (int i = 0; i < span; ++i) iso[static_cast<std::size_t>(i)] = date::toISO(today - i);
+
+    Result l{"is_completed_on_legacy", kQueries};
+    hits = 0;
+    l.seconds = seconds([&] {
+        for (const auto& q : queries)
+            hits += legacy[q.first].dates.count(iso[static_cast<std::size_t>(today - q.second)]);
+    });
+    keep(hits);
+    out.push_back(l);
+}
+
+HABIT_BENCH(current_streak) {
+    // every habit is one streak covering the whole history
+    std::vector<Habit> habits = generateStreaks(cfg.habits, 365 * cfg.years);
+    date::Day today = date::today();
+    const int kRounds = 200;
+
+    Result r{"current_streak", static_cast<std::uint64_t>(kRounds) * habits.size()};
+    long long total = 0;
+    r.seconds = seconds([&] {
+        for (int i = 0; i < kRounds; ++i)
+            for (const auto& h : habits) total += h.currentStreak(today);
+    });
+    keep(total);
+    out.push_back(r);
+
+    // the day walk formats one date per streak day, so sample a few habits
+    std::size_t n = std::min<std::size_t>(habits.size(), 20);
+    std::vector<LegacyHabit> legacy;
+    for (std::size_t i = 0; i < n; ++i) legacy.emplace_back(habits[i]);
+    Result l{"current_streak_legacy", n};
+    l.seconds = seconds([&] {
+        for (const auto& h : legacy) total += h.currentStreak();
+    });
+    keep(total);
+    out.push_back(l);
+}
+
+// ----------------- Dates -----------------
+
+HABIT_BENCH(date_today) {
+    const std::size_t kCalls = 1000000;
+    Result r{"date_today", kCalls};
+    long long sum = 0;
+    r.seconds = seconds([&] {
+        for (std::size_t i = 0; i < kCalls; ++i) sum += date::today();
+    });
+    keep(sum);
+    out.push_back(r);
+
+    Result l{"date_today_legacy", kCalls / 10};
+    l.seconds = seconds([&] {
+        for (std::size_t i = 0; i < kCalls / 10; ++i)
+            sum += static_cast<long long>(legacyTodayISO(std::chrono::system_clock::now()).size());
+    });
+    keep(sum);
+    out.push_back(l);
+
+    Result f{"date_to_iso", kCalls};
+    f.seconds = seconds([&] {
+        for (std::size_t i = 0; i < kCalls; ++i)
+            sum += static_cast<long long>(date::toISO(static_cast<date::Day>(i % 40000)).size());
+    });
+    keep(sum);
+    out.push_back(f);
+}
+
+// ----------------- HabitManager -----------------
+
+HABIT_BENCH(find) {
+    Config namesOnly = cfg;
+    namesOnly.years = 0;                  // no history
+    HabitManager manager;
+    manager.addHabits(generateHabits(namesOnly));
+    std::mt19937 rng(cfg.seed);
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) names.push_back("habit " + std::to_string(rng() % cfg.habits));
+
+    const std::size_t kLookups = 1000000;
+    Result r{"find", kLookups};
+    std::size_t found = 0;
+    r.seconds = seconds([&] {
+        for (std::size_t i = 0; i < kLookups; ++i) found += manager.find(names[i % names.size()]) != nullptr;
+    });
+    keep(found);
+    out.push_back(r);
+}
+
+HABIT_BENCH(load_from_db) {
+    ensureDataset(cfg);
+    HabitManager manager;
+    manager.openDB(datasetDB(cfg));
+    Result r{"load_from_db"};
+    r.seconds = seconds([&] { manager.loadFromDB(); });
+    for (const auto& h : manager.getHabits()) r.ops += h.completions().count();
+    r.extra["habits"] = static_cast<double>(manager.getHabits().size());
+    r.extra["startup_ms"] = r.seconds * 1e3;
+    out.push_back(r);
+}
+
+HABIT_BENCH(json_roundtrip) {
+    ensureDataset(cfg);
+    HabitManager manager;
+    manager.load(datasetJSON(cfg));
+    HabitSnapshot habits = manager.getHabits();
+    std::string path = cfg.dir + "/bench_out.json";
+    // peak_heap_mb counts operator new only: the DOM and stream buffers, but
+    // not bitmap words, which the pool serves from slabs already held
+    auto record = [&](const char* name, double secs, std::int64_t peakBytes) {
+        Result r{name, static_cast<std::uint64_t>(fileSize(path))};
+        r.seconds = secs;
+        r.extra["mb_per_sec"] = static_cast<double>(r.ops) / 1e6 / secs;
+        r.extra["peak_heap_mb"] = static_cast<double>(peakBytes) / 1e6;
+        out.push_back(r);
+    };
+
+    Heap::resetPeak();
+    std::int64_t base = Heap::live;
+    double secs = seconds([&] { manager.save(path); });
+    record("json_save", secs, Heap::peak - base);
+
+    Heap::resetPeak();
+    base = Heap::live;
+    secs = seconds([&] {
+        json j = json::array();
+        for (const auto& h : habits) j.push_back(h.toJson());
+        std::ofstream o(path);
+        o << j.dump(2);
+    });
+    record("json_save_dom", secs, Heap::peak - base);
+
+    Heap::resetPeak();
+    base = Heap::live;
+    std::size_t loaded = 0;
+    secs = seconds([&] {
+        std::ifstream in(path);
+        readHabitJson(in, [&](Habit&& h) { loaded += h.completions().count(); });
+    });
+    keep(loaded);
+    record("json_load", secs, Heap::peak - base);
+
+    Heap::resetPeak();
+    base = Heap::live;
+    secs = seconds([&] {
+        std::ifstream in(path);
+        json j;
+        in >> j;
+        for (const auto& item : j) loaded += Habit::fromJson(item).completions().count();
+    });
+    keep(loaded);
+    record("json_load_dom", secs, Heap::peak - base);
+}
+
+HABIT_BENCH(set_today) {
+    std::string path = cfg.dir + "/bench_toggle.db";
+    removeDB(path);
+    HabitManager manager;
+    manager.openDB(path);
+    int n = std::min(cfg.habits, 1000);
+    for (int i = 0; i < n; ++i) manager.addHabit("habit " + std::to_string(i));
+    auto toggle = [&](std::size_t ops) {
+        for (std::size_t i = 0; i < ops; ++i)
+            manager.setToday("habit " + std::to_string(i % static_cast<std::size_t>(n)), i / n % 2 == 0);
+    };
+
+    Result sync{"set_today", 2000};
+    sync.seconds = seconds([&] { toggle(sync.ops); });
+    out.push_back(sync);
+
+    Result batched{"set_today_batched", 100000};
+    manager.beginBatch(10000);
+    batched.seconds = seconds([&] { toggle(batched.ops); manager.flush(); });
+    manager.endBatch();
+    out.push_back(batched);
+
+    Result async{"set_today_async", 100000};
+    manager.startAsyncWriter();
+    async.seconds = seconds([&] { toggle(async.ops); manager.flush(); });
+    auto st = manager.asyncWriterStats();
+    async.extra["rows_written"] = static_cast<double>(st.written);
+    async.extra["errors"] = static_cast<double>(st.failed);     // rows lost fail the run
+    async.extra["coalesced"] = static_cast<double>(st.coalesced);
+    async.extra["max_latency_us"] = static_cast<double>(st.maxLatencyUs);
+    manager.stopAsyncWriter();
+    out.push_back(async);
+}
+
+HABIT_BENCH(bulk_import) {
+    std::vector<Habit> habits = generateHabits(cfg);
+    std::string path = cfg.dir + "/bench_import.db";
+    auto import = [&](const char* name, bool batch, std::size_t maxRows) {
+        removeDB(path);
+        HabitManager manager;
+        manager.openDB(path);
+        Result r{name};
+        r.seconds = seconds([&] {
+            if (batch) manager.beginBatch(100000);
+            for (const auto& h : habits) {
+                if (r.ops >= maxRows) break;
+                r.ops += h.completions().count();
+                manager.addHabit(Habit(h));
+            }
+            if (batch) manager.endBatch();
+        });
+        out.push_back(r);
+    };
+    import("bulk_import_autocommit", false, 20000);     // one transaction per row
+    import("bulk_import_batched", true, static_cast<std::size_t>(-1));
+}
+
+// ----------------- Analytics -----------------
+
+HABIT_BENCH(stats_365d) {
+    HabitManager manager;
+    manager.addHabits(generateHabits(cfg));
+    date::Day today = date::today();
+    Result r{"stats_365d", static_cast<std::uint64_t>(cfg.habits)};
+    std::vector<HabitStats> stats;
+    r.seconds = seconds([&] { stats = manager.stats(today - 364, today); });
+    keep(stats);
+    out.push_back(r);
+}
@@ -0,0 +1,115 @@
+#include "Generator.h"
+#include "HabitManager.h"
+#include "HabitJson.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+namespace bench {
+
+std::vector<Habit> generateHabits(const Config& cfg) {
+    std::mt19937 rng(cfg.seed);
+    std::bernoulli_distribution done(cfg.density);
+    date::Day today = date::today();
+    date::Day first = today - 365 * cfg.years + 1;
+
+    std::vector<Habit> out;
+    out.reserve(static_cast<std::size_t>(cfg.habits));
+    for (int i = 0; i < cfg.habits; ++i) {
+        Habit h("habit " + std::to_string(i));
+        for (date::Day d = first; d <= today; ++d)
+            if (done(rng)) h.setCompletedOn(d, true);
+        out.push_back(std::move(h));
+    }
+    return out;
+}
+
+std::vector<Habit> generateStreaks(int habits, int days) {
+    date::Day today = date::today();
+    std::vector<Habit> out;
+    out.reserve(static_cast<std::size_t>(habits));
+    for (int i = 0; i < habits; ++i) {
+        Habit h("streak " + std::to_string(i));
+        for (date::Day d = today - days + 1; d <= today; ++d) h.setCompletedOn(d, true);
+        out.push_back(std::move(h));
+    }
+    return out;
+}
+
+std::size_t writeDataset(const Config& cfg, const std::string& dbPath,
+                         const std::string& logPath, const std::string& jsonPath) {
+    removeDB(dbPath);
+    std::remove(logPath.c_str());
+    std::vector<Habit> habits = generateHabits(cfg);
+    std::size_t rows = 0;
+    for (const auto& h : habits) rows += h.completions().count();
+
+    for (Backend backend : {Backend::Sqlite, Backend::Log}) {
+        HabitManager manager;
+        if (!manager.openDB(backend == Backend::Log ? logPath : dbPath, backend)) return 0;
+        manager.beginBatch(100000);
+        manager.addHabits(habits);
+        manager.endBatch();
+        if (backend == Backend::Sqlite) manager.save(jsonPath);
+    }
+    return rows;
+}
+
+void ensureDataset(const Config& cfg) {
+    std::ifstream db(datasetDB(cfg)), log(datasetLog(cfg)), js(datasetJSON(cfg));
+    if (db && log && js) return;
+    writeDataset(cfg, datasetDB(cfg), datasetLog(cfg), datasetJSON(cfg));
+}
+
+std::string ensureImportFile(const Config& cfg, bool csv) {
+    std::string path = cfg.dir + "/import_" + std::to_string(cfg.importMB) + "mb_s" +
+                       std::to_string(cfg.seed) + (csv ? ".csv" : ".json");
+    if (std::ifstream(path)) return path;
+
+    const std::uint64_t target = static_cast<std::uint64_t>(cfg.importMB) << 20;
+    std::mt19937 rng(cfg.seed);
+    std::bernoulli_distribution done(cfg.density);
+    date::Day today = date::today();
+    date::Day first = today - 365 * cfg.years + 1;
+
+    auto next = [&, i = 0]() mutable {
+        Habit h("import " + std::to_string(i++));
+        for (date::Day d = first; d <= today; ++d)
+            if (done(rng)) h.setCompletedOn(d, true);
+        return h;
+    };
+    auto written = [](std::ofstream& o) { return static_cast<std::uint64_t>(o.tellp()); };
+
+    std::ofstream out(path, std::ios::binary);
+    if (csv) {
+        out << "habit,date\n";
+        while (written(out) < target) {
+            Habit h = next();
+            std::string_view name = h.getName();
+            h.completions().forEach([&](date::Day d) { out << name << ',' << date::toISO(d) << '\n'; });
+        }
+    } else {
+        HabitJsonWriter writer(out, false);
+        while (written(out) < target) writer.write(next());
+        writer.finish();
+    }
+    return path;
+}
+
+void removeDB(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+static std::string datasetStem(const Config& cfg) {
+    return cfg.dir + "/habits_" + std::to_string(cfg.habits) + "x" + std::to_string(cfg.years) +
+           "_d" + std::to_string(static_cast<int>(cfg.density * 100)) +
+           "_s" + std::to_string(cfg.seed);
+}
+
+std::string datasetDB(const Config& cfg)   { return datasetStem(cfg) + ".db"; }
+std::string datasetLog(const Config& cfg)  { return datasetStem(cfg) + ".log"; }
+std::string datasetJSON(const Config& cfg) { return datasetStem(cfg) + ".json"; }
+
+} // namespace bench
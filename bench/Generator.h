@@ -0,0 +1,35 @@
+#pragma once
+#include "Bench.h"
+#include "Habit.h"
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// N habits with `years` of history ending today; each day is completed with
+// probability `density`. Deterministic for a given seed.
+std::vector<Habit> generateHabits(const Config& cfg);
+
+// habits whose whole history is one unbroken streak ending today
+std::vector<Habit> generateStreaks(int habits, int days);
+
+// write the generated habits to a fresh SQLite DB, an event log and a JSON
+// export; returns the number of completion rows written
+std::size_t writeDataset(const Config& cfg, const std::string& dbPath,
+                         const std::string& logPath, const std::string& jsonPath);
+
+// the shared dataset for cfg, generated on first use and reused afterwards
+void ensureDataset(const Config& cfg);
+
+// a CSV ("name,date" rows) or JSON export of about cfg.importMB megabytes of
+// generated history for the bulk-import benches, written on first use
+std::string ensureImportFile(const Config& cfg, bool csv);
+
+// delete a DB file together with its -wal/-shm side files
+void removeDB(const std::string& path);
+
+std::string datasetDB(const Config& cfg);     // <dir>/habits_<N>x<Y>.db
+std::string datasetLog(const Config& cfg);    // <dir>/habits_<N>x<Y>.log
+std::string datasetJSON(const Config& cfg);   // <dir>/habits_<N>x<Y>.json
+
+} // namespace bench
@@ -0,0 +1,61 @@
+// Bulk import: parallel vs single-threaded parsing of generated CSV and JSON
+// histories (--import-mb sets the file size), merging into existing habits
+// and writing through each storage backend.
+
+#include "Bench.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include <cstdio>
+
+using namespace bench;
+
+namespace {
+
+Result importInto(HabitManager& manager, const std::string& name, const std::string& path,
+                  unsigned threads) {
+    ImportOptions opts;
+    opts.threads = threads;
+    ImportStats st;
+    Result r{name};
+    r.seconds = seconds([&] { manager.importFile(path, opts, &st); });
+    r.ops = st.rows;
+    r.extra["mb_per_sec"] = st.mbPerSec();
+    r.extra["added"] = static_cast<double>(st.added);
+    r.extra["duplicates"] = static_cast<double>(st.duplicates);
+    return r;
+}
+
+} // namespace
+
+HABIT_BENCH(import_csv) {
+    std::string path = ensureImportFile(cfg, true);
+    {
+        HabitManager manager;
+        out.push_back(importInto(manager, "import_csv", path, 0));
+        // same file again: every row is already there
+        out.push_back(importInto(manager, "import_csv_merge", path, 0));
+    }
+    HabitManager single;
+    out.push_back(importInto(single, "import_csv_1t", path, 1));
+}
+
+HABIT_BENCH(import_json) {
+    std::string path = ensureImportFile(cfg, false);
+    HabitManager manager;
+    out.push_back(importInto(manager, "import_json", path, 0));
+    HabitManager single;
+    out.push_back(importInto(single, "import_json_1t", path, 1));
+}
+
+HABIT_BENCH(import_to_storage) {
+    std::string path = ensureImportFile(cfg, true);
+    for (Backend backend : {Backend::Sqlite, Backend::Log}) {
+        bool log = backend == Backend::Log;
+        std::string db = cfg.dir + (log ? "/bench_import_bulk.log" : "/bench_import_bulk.db");
+        if (log) std::remove(db.c_str());
+        else removeDB(db);
+        HabitManager manager;
+        manager.openDB(db, backend);
+        out.push_back(importInto(manager, log ? "import_csv_log" : "import_csv_sqlite", path, 0));
+    }
+}
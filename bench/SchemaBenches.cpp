@@ -0,0 +1,196 @@
+// Completions schema before and after the integer-day redesign. A DB in the
+// original layout (ISO date text, rowid tables, AUTOINCREMENT) is written
+// from the generated habits and queried; opening it through the app then
+// migrates it in place, and the same queries run on the new layout.
+//
+//   schema_range_scan_*   one habit, a random 30-day window, decoded to days
+//   schema_full_load_*    the ordered habits/completions scan startup used to do
+//   schema_full_load_words  the same days read as packed words, as startup does now
+//   schema_migrate        the in-place upgrade (open on the legacy file)
+//   schema_startup        open + load through HabitManager after the upgrade
+
+#include "Bench.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include <filesystem>
+#include <random>
+#include <sqlite3.h>
+
+using namespace bench;
+
+namespace {
+
+// the layout every file had before schema versions
+const char* const kLegacySql =
+    "CREATE TABLE habits(id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT UNIQUE);"
+    "CREATE TABLE completions(habit_id INTEGER, date TEXT, PRIMARY KEY(habit_id,date));";
+
+std::size_t writeLegacy(const Config& cfg, const std::string& path) {
+    removeDB(path);
+    sqlite3* db;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db, kLegacySql, nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    sqlite3_stmt *habit, *done;
+    sqlite3_prepare_v2(db, "INSERT INTO habits(name) VALUES(?);", -1, &habit, nullptr);
+    sqlite3_prepare_v2(db, "INSERT INTO completions(habit_id,date) VALUES(?,?);", -1, &done, nullptr);
+    std::size_t rows = 0;
+    for (const auto& h : generateHabits(cfg)) {
+        std::string name(h.getName());
+        sqlite3_bind_text(habit, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(habit);
+        sqlite3_reset(habit);
+        sqlite3_int64 id = sqlite3_last_insert_rowid(db);
+        h.completions().forEach([&](date::Day d) {
+            std::string iso = date::toISO(d);
+            sqlite3_bind_int64(done, 1, id);
+            sqlite3_bind_text(done, 2, iso.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_step(done);
+            sqlite3_reset(done);
+            ++rows;
+        });
+    }
+    sqlite3_finalize(habit);
+    sqlite3_finalize(done);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+    return rows;
+}
+
+double fileMB(const std::string& path) {
+    std::error_code ec;
+    double mb = static_cast<double>(std::filesystem::file_size(path, ec)) / 1e6;
+    auto wal = std::filesystem::file_size(path + "-wal", ec);
+    return ec ? mb : mb + static_cast<double>(wal) / 1e6;
+}
+
+// decodes the day column the way each layout stores it
+date::Day columnDay(sqlite3_stmt* s, int col, bool legacy) {
+    if (!legacy) return sqlite3_column_int(s, col);
+    date::Day day = 0;
+    date::parseISO(reinterpret_cast<const char*>(sqlite3_column_text(s, col)),
+                   static_cast<std::size_t>(sqlite3_column_bytes(s, col)), day);
+    return day;
+}
+
+void rangeScans(const Config& cfg, const std::string& path, bool legacy, std::vector<Result>& out) {
+    sqlite3* db;
+    sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    sqlite3_stmt* s;
+    sqlite3_prepare_v2(db, legacy ? "SELECT date FROM completions WHERE habit_id=? AND date BETWEEN ? AND ?;"
+                                  : "SELECT day FROM completions WHERE habit_id=? AND day BETWEEN ? AND ?;",
+                       -1, &s, nullptr);
+    std::mt19937 rng(cfg.seed);
+    date::Day today = date::today();
+    int span = cfg.years * 365 - 30;
+    const int queries = 20000;
+    std::uint64_t rows = 0;
+    long long sink = 0;
+
+    Result r{legacy ? "schema_range_scan_legacy" : "schema_range_scan", queries};
+    r.seconds = seconds([&] {
+        for (int q = 0; q < queries; ++q) {
+            date::Day from = today - 29 - static_cast<date::Day>(rng() % span);
+            sqlite3_bind_int(s, 1, 1 + static_cast<int>(rng() % cfg.habits));
+            if (legacy) {
+                std::string a = date::toISO(from), b = date::toISO(from + 29);
+                sqlite3_bind_text(s, 2, a.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(s, 3, b.c_str(), -1, SQLITE_TRANSIENT);
+            } else {
+                sqlite3_bind_int(s, 2, from);
+                sqlite3_bind_int(s, 3, from + 29);
+            }
+            while (sqlite3_step(s) == SQLITE_ROW) { sink += columnDay(s, 0, legacy); ++rows; }
+            sqlite3_reset(s);
+        }
+    });
+    keep(sink);
+    r.extra["rows_per_query"] = static_cast<double>(rows) / queries;
+    out.push_back(r);
+
+    sqlite3_finalize(s);
+    sqlite3_close(db);
+}
+
+void fullLoad(const std::string& path, bool legacy, std::vector<Result>& out) {
+    sqlite3* db;
+    sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    sqlite3_stmt* s;
+    sqlite3_prepare_v2(db, legacy ? "SELECT h.id, h.name, c.date FROM habits h "
+                                    "LEFT JOIN completions c ON c.habit_id = h.id ORDER BY h.id, c.date;"
+                                  : "SELECT h.id, h.name, c.day FROM habits h "
+                                    "LEFT JOIN completions c ON c.habit_id = h.id ORDER BY h.id, c.day;",
+                       -1, &s, nullptr);
+    long long sink = 0;
+    Result r{legacy ? "schema_full_load_legacy" : "schema_full_load"};
+    r.seconds = seconds([&] {
+        while (sqlite3_step(s) == SQLITE_ROW) {
+            if (sqlite3_column_type(s, 2) != SQLITE_NULL) sink += columnDay(s, 2, legacy);
+            ++r.ops;
+        }
+    });
+    keep(sink);
+    out.push_back(r);
+
+    sqlite3_finalize(s);
+    sqlite3_close(db);
+}
+
+// ops are days, so the figure compares with schema_full_load per row
+void fullLoadWords(const std::string& path, std::vector<Result>& out) {
+    sqlite3* db;
+    sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    sqlite3_stmt* s;
+    sqlite3_prepare_v2(db, "SELECT h.id, h.name, w.word, w.bits FROM habits h "
+                           "LEFT JOIN completion_words w ON w.habit_id = h.id ORDER BY h.id, w.word;",
+                       -1, &s, nullptr);
+    std::uint64_t rows = 0;
+    Result r{"schema_full_load_words"};
+    r.seconds = seconds([&] {
+        while (sqlite3_step(s) == SQLITE_ROW) {
+            r.ops += static_cast<std::uint64_t>(__builtin_popcountll(
+                static_cast<std::uint64_t>(sqlite3_column_int64(s, 3))));
+            ++rows;
+        }
+    });
+    r.extra["rows"] = static_cast<double>(rows);
+    out.push_back(r);
+
+    sqlite3_finalize(s);
+    sqlite3_close(db);
+}
+
+} // namespace
+
+HABIT_BENCH(schema_queries) {
+    std::string path = cfg.dir + "/bench_schema.db";
+    std::filesystem::create_directories(cfg.dir);
+    std::size_t rows = writeLegacy(cfg, path);
+    double legacyMB = fileMB(path);
+
+    rangeScans(cfg, path, true, out);
+    fullLoad(path, true, out);
+
+    Result migrate{"schema_migrate", rows};
+    {
+        HabitManager manager;
+        migrate.seconds = seconds([&] { manager.openDB(path); });
+    }
+    migrate.extra["file_mb_before"] = legacyMB;
+    migrate.extra["file_mb_after"] = fileMB(path);     // closed, so checkpointed
+    out.push_back(migrate);
+
+    rangeScans(cfg, path, false, out);
+    fullLoad(path, false, out);
+    fullLoadWords(path, out);
+
+    HabitManager manager;
+    Result r{"schema_startup", rows};
+    r.seconds = seconds([&] {
+        manager.openDB(path);
+        manager.loadFromDB();
+    });
+    r.extra["startup_ms"] = r.seconds * 1e3;
+    out.push_back(r);
+    removeDB(path);
+}
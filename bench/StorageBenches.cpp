@@ -0,0 +1,66 @@
+// SQLite vs the append-only event log: toggle throughput and cold start
+// (open + full load) on the shared dataset.
+
+#include "Bench.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using namespace bench;
+
+namespace {
+
+const char* backendName(Backend backend) { return backend == Backend::Log ? "log" : "sqlite"; }
+
+void removeStore(Backend backend, const std::string& path) {
+    if (backend == Backend::Log) std::remove(path.c_str());
+    else removeDB(path);
+}
+
+} // namespace
+
+HABIT_BENCH(storage_writes) {
+    for (Backend backend : {Backend::Sqlite, Backend::Log}) {
+        std::string prefix = std::string("storage_writes_") + backendName(backend);
+        std::string path = cfg.dir + "/bench_writes." + backendName(backend);
+        removeStore(backend, path);
+        HabitManager manager;
+        manager.openDB(path, backend);
+        int n = std::min(cfg.habits, 1000);
+        for (int i = 0; i < n; ++i) manager.addHabit("habit " + std::to_string(i));
+        auto toggle = [&](std::size_t ops) {
+            for (std::size_t i = 0; i < ops; ++i)
+                manager.setToday("habit " + std::to_string(i % static_cast<std::size_t>(n)), i / n % 2 == 0);
+        };
+
+        // one durable-to-the-OS write per toggle
+        Result single{prefix, backend == Backend::Log ? 200000u : 2000u};
+        single.seconds = seconds([&] { toggle(single.ops); });
+        out.push_back(single);
+
+        Result batched{prefix + "_batched", 200000};
+        manager.beginBatch(10000);
+        batched.seconds = seconds([&] { toggle(batched.ops); manager.flush(); });
+        manager.endBatch();
+        out.push_back(batched);
+    }
+}
+
+HABIT_BENCH(storage_cold_start) {
+    ensureDataset(cfg);
+    for (Backend backend : {Backend::Sqlite, Backend::Log}) {
+        std::string path = backend == Backend::Log ? datasetLog(cfg) : datasetDB(cfg);
+        HabitManager manager;
+        Result r{std::string("storage_cold_start_") + backendName(backend)};
+        r.seconds = seconds([&] {
+            manager.openDB(path, backend);
+            manager.loadFromDB();
+        });
+        for (const auto& h : manager.getHabits()) r.ops += h.completions().count();
+        r.extra["startup_ms"] = r.seconds * 1e3;
+        r.extra["file_mb"] = static_cast<double>(std::filesystem::file_size(path)) / 1e6;
+        out.push_back(r);
+    }
+}
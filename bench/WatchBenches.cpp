@@ -0,0 +1,112 @@
+// Watch mode: a second connection (standing in for a cron job or script)
+// writes to the dataset DB while a viewer picks the changes up. Compares a
+// delta refresh against the full reload it replaces, and measures how long a
+// commit takes to reach the viewer's watch callback.
+
+#include "Bench.h"
+#include "Generator.h"
+#include "HabitManager.h"
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+
+using namespace bench;
+
+namespace {
+
+std::string watchDB(const Config& cfg) {
+    ensureDataset(cfg);
+    std::string path = cfg.dir + "/bench_watch.db";
+    removeDB(path);
+    std::filesystem::copy_file(datasetDB(cfg), path);
+    return path;
+}
+
+std::size_t completions(const HabitSnapshot& habits) {
+    std::size_t n = 0;
+    for (const auto& h : habits) n += h.completions().count();
+    return n;
+}
+
+} // namespace
+
+HABIT_BENCH(watch_refresh) {
+    std::string path = watchDB(cfg);
+    HabitManager viewer, writer;
+    viewer.openDB(path);
+    writer.openDB(path);
+
+    Result full{"watch_full_reload"};
+    full.seconds = seconds([&] { viewer.loadFromDB(); });
+    full.ops = completions(viewer.getHabits());
+    out.push_back(full);
+
+    writer.loadFromDB();
+    HabitSnapshot habits = writer.getHabits();
+    std::size_t n = habits.size();
+    date::Day today = date::today();
+
+    // each round commits k external changes, then the viewer refreshes once
+    for (std::size_t k : {1u, 100u, 1000u}) {
+        const int rounds = 100;
+        Result r{"watch_refresh_" + std::to_string(k)};
+        for (int round = 0; round < rounds; ++round) {
+            writer.beginBatch(k + 1, std::chrono::hours(1));
+            for (std::size_t i = 0; i < k; ++i) {
+                std::size_t slot = (round * k + i) % n;
+                bool done = writer.getHabits()[slot].isCompletedOn(today);
+                writer.setToday(habits.handle(slot), !done);
+            }
+            writer.endBatch();
+            r.seconds += seconds([&] { viewer.refreshFromDB(); });
+            r.ops += k;
+        }
+        r.extra["ms_per_refresh"] = r.seconds * 1e3 / rounds;
+        out.push_back(r);
+    }
+
+    HabitSnapshot a = viewer.getHabits(), b = writer.getHabits();
+    double mismatches = a.size() == b.size() ? 0 : 1;
+    for (std::size_t i = 0; i < std::min(a.size(), b.size()); ++i)
+        mismatches += a[i].getName() != b[i].getName() ||
+                      a[i].completions().count() != b[i].completions().count() ||
+                      a[i].isCompletedOn(today) != b[i].isCompletedOn(today);
+    out.back().extra["mismatches"] = mismatches;
+}
+
+HABIT_BENCH(watch_latency) {
+    std::string path = watchDB(cfg);
+    HabitManager viewer, writer;
+    viewer.openDB(path);
+    writer.openDB(path);
+    viewer.loadFromDB();
+    writer.loadFromDB();
+
+    std::atomic<std::uint64_t> refreshes{0};
+    viewer.startWatching([&] { ++refreshes; });
+
+    // one committed toggle at a time, timed until the viewer has applied it
+    const int rounds = 100;
+    Result r{"watch_latency", rounds};
+    double worst = 0, missed = 0;
+    HabitSnapshot habits = writer.getHabits();
+    date::Day today = date::today();
+    for (int i = 0; i < rounds; ++i) {
+        std::size_t slot = static_cast<std::size_t>(i) % habits.size();
+        bool done = !writer.getHabits()[slot].isCompletedOn(today);
+        std::uint64_t before = refreshes.load();
+        auto t0 = std::chrono::steady_clock::now();
+        writer.setToday(habits.handle(slot), done);
+        while (refreshes.load() == before &&
+               std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2))
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        missed += refreshes.load() == before;
+        worst = std::max(worst, s);
+        r.seconds += s;
+    }
+    viewer.stopWatching();
+    r.extra["max_ms"] = worst * 1e3;
+    r.extra["missed"] = missed;
+    out.push_back(r);
+}
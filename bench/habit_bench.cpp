@@ -0,0 +1,177 @@
+// habit_bench: microbenchmarks and load generation for the hot paths.
+//
+//   habit_bench [--habits N] [--years Y] [--density P] [--seed S] [--dir DIR]
+//               [--filter SUBSTR] [--out FILE] [--baseline FILE] [--threshold F]
+//               [--import-mb MB] [--tracker PATH] [--generate]
+//
+// Results are written as JSON (to --out, or stdout). With --baseline, any
+// benchmark whose ns/op grew by more than --threshold (default 0.10) is
+// reported and the exit code is 2. A benchmark that checks its own results
+// reports an "errors" extra; any non-zero count makes the exit code 3.
+
+#include "Bench.h"
+#include "Generator.h"
+#include <nlohmann/json.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <streambuf>
+
+using nlohmann::json;
+
+// ----------------- Heap accounting -----------------
+
+std::atomic<std::uint64_t> bench::Heap::allocs{0};
+std::atomic<std::int64_t> bench::Heap::live{0};
+std::atomic<std::int64_t> bench::Heap::peak{0};
+
+void* operator new(std::size_t n) {
+    void* p = std::malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    ++bench::Heap::allocs;
+    std::int64_t now = bench::Heap::live += static_cast<std::int64_t>(malloc_usable_size(p));
+    std::int64_t prev = bench::Heap::peak.load(std::memory_order_relaxed);
+    while (now > prev && !bench::Heap::peak.compare_exchange_weak(prev, now)) {}
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    bench::Heap::live -= static_cast<std::int64_t>(malloc_usable_size(p));
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+std::vector<std::pair<std::string, bench::Fn>>& bench::Registry::all() {
+    static std::vector<std::pair<std::string, Fn>> benches;
+    return benches;
+}
+
+// ----------------- Driver -----------------
+
+namespace {
+
+// swallows HabitManager's progress messages while a benchmark runs
+struct NullBuf : std::streambuf {
+    int overflow(int c) override { return c; }
+};
+
+json toJson(const bench::Config& cfg, const std::vector<bench::Result>& results) {
+    json j;
+    j["config"] = {{"habits", cfg.habits}, {"years", cfg.years},
+                   {"density", cfg.density}, {"seed", cfg.seed}};
+    j["results"] = json::array();
+    for (const auto& r : results) {
+        json e = {{"name", r.name}, {"ops", r.ops}, {"seconds", r.seconds},
+                  {"ns_per_op", r.nsPerOp()}, {"ops_per_sec", r.opsPerSec()}};
+        for (const auto& kv : r.extra) e[kv.first] = kv.second;
+        j["results"].push_back(e);
+    }
+    return j;
+}
+
+// names of benchmarks slower than baseline * (1 + threshold)
+std::vector<std::string> regressions(const json& baseline, const std::vector<bench::Result>& results,
+                                     double threshold) {
+    std::vector<std::string> slow;
+    for (const auto& r : results) {
+        for (const auto& b : baseline.value("results", json::array())) {
+            if (b.value("name", "") != r.name) continue;
+            double before = b.value("ns_per_op", 0.0);
+            if (before > 0 && r.nsPerOp() > before * (1 + threshold)) {
+                std::cerr << "REGRESSION " << r.name << ": " << before << " -> "
+                          << r.nsPerOp() << " ns/op\n";
+                slow.push_back(r.name);
+            }
+        }
+    }
+    return slow;
+}
+
+// benchmarks whose consistency checks failed
+bool anyErrors(const std::vector<bench::Result>& results) {
+    bool failed = false;
+    for (const auto& r : results) {
+        auto it = r.extra.find("errors");
+        if (it == r.extra.end() || it->second == 0) continue;
+        std::cerr << "FAILED " << r.name << ": " << it->second << " errors\n";
+        failed = true;
+    }
+    return failed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Config cfg;
+#ifdef HABIT_TRACKER_BIN
+    cfg.tracker = HABIT_TRACKER_BIN;
+#endif
+    std::string outPath, baselinePath;
+    double threshold = 0.10;
+    bool generateOnly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        auto arg = [&](const char* flag) { return std::strcmp(argv[i], flag) == 0 && i + 1 < argc; };
+        if (arg("--habits"))         cfg.habits = std::atoi(argv[++i]);
+        else if (arg("--years"))     cfg.years = std::atoi(argv[++i]);
+        else if (arg("--density"))   cfg.density = std::atof(argv[++i]);
+        else if (arg("--seed"))      cfg.seed = static_cast<unsigned>(std::atol(argv[++i]));
+        else if (arg("--dir"))       cfg.dir = argv[++i];
+        else if (arg("--filter"))    cfg.filter = argv[++i];
+        else if (arg("--import-mb")) cfg.importMB = std::atoi(argv[++i]);
+        else if (arg("--tracker"))   cfg.tracker = argv[++i];
+        else if (arg("--out"))       outPath = argv[++i];
+        else if (arg("--baseline"))  baselinePath = argv[++i];
+        else if (arg("--threshold")) threshold = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--generate") == 0) generateOnly = true;
+        else { std::cerr << "unknown argument: " << argv[i] << "\n"; return 1; }
+    }
+    std::filesystem::create_directories(cfg.dir);
+
+    NullBuf nullBuf;
+    std::streambuf* coutBuf = std::cout.rdbuf(&nullBuf);
+
+    if (generateOnly) {
+        std::size_t rows = bench::writeDataset(cfg, bench::datasetDB(cfg), bench::datasetLog(cfg),
+                                               bench::datasetJSON(cfg));
+        std::cout.rdbuf(coutBuf);
+        std::cerr << "wrote " << bench::datasetDB(cfg) << ", " << bench::datasetLog(cfg) << " and "
+                  << bench::datasetJSON(cfg) << " (" << rows << " completions)\n";
+        return 0;
+    }
+
+    std::vector<bench::Result> results;
+    for (const auto& b : bench::Registry::all()) {
+        if (!cfg.filter.empty() && b.first.find(cfg.filter) == std::string::npos) continue;
+        std::size_t first = results.size();
+        b.second(cfg, results);
+        for (std::size_t i = first; i < results.size(); ++i)
+            std::cerr << results[i].name << ": " << results[i].nsPerOp() << " ns/op, "
+                      << results[i].opsPerSec() << " ops/s\n";
+    }
+    std::cout.rdbuf(coutBuf);
+
+    json report = toJson(cfg, results);
+    if (outPath.empty()) {
+        std::cout << report.dump(2) << "\n";
+    } else {
+        std::ofstream out(outPath);
+        out << report.dump(2) << "\n";
+    }
+
+    bool failed = anyErrors(results);
+    if (!baselinePath.empty()) {
+        std::ifstream in(baselinePath);
+        if (!in) { std::cerr << "cannot read baseline " << baselinePath << "\n"; return 1; }
+        json baseline = json::parse(in, nullptr, false);
+        if (baseline.is_discarded()) { std::cerr << "bad baseline " << baselinePath << "\n"; return 1; }
+        if (!regressions(baseline, results, threshold).empty() && !failed) return 2;
+    }
+    return failed ? 3 : 0;
+}
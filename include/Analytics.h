@@ -0,0 +1,35 @@
+#pragma once
+#include "Habit.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// Structured results for reports; computed from the completion bitmaps a
+// word at a time rather than by probing single days.
+
+struct HabitStats {
+    std::string_view name;              // the habit's interned name
+    int completed = 0;                  // completions in [from, to]
+    int days = 0;                       // length of the range
+    double rate = 0.0;                  // completed / days
+    int currentStreak = 0;              // streak as of `to`
+    int longestStreak = 0;              // all-time
+    std::array<int, 7> byWeekday{};     // completions in range per weekday, 0 = Sunday
+};
+
+struct YearHeatmap {
+    enum Cell : std::uint8_t { kMissed = 0, kDone = 1, kOutside = 2 };
+
+    int year = 0;
+    date::Day firstDay = 0;             // Sunday on or before Jan 1
+    int weeks = 0;                      // columns
+    std::vector<std::uint8_t> cells;    // (week, weekday) at week * 7 + weekday
+};
+
+HabitStats habitStats(const Habit& h, date::Day from, date::Day to);
+YearHeatmap yearHeatmap(const Habit& h, int year);
+
+// run f(i) for i in [0, n), split across hardware threads when n is large
+void parallelFor(std::size_t n, const std::function<void(std::size_t)>& f);
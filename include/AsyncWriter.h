@@ -0,0 +1,67 @@
+#pragma once
+#include "Date.h"
+#include "Storage.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Background writer for completion changes. Producers push records into a
+// bounded queue (push blocks only when it is full); a worker thread with its
+// own storage handle drains whatever is queued, keeps the last record per
+// (habit, day), and writes the batch in one transaction. A batch that fails
+// (the DB stays locked past the busy timeout, the disk is full) is retried
+// kAttempts times, then dropped and counted in Stats::failed.
+class AsyncWriter {
+public:
+    struct Stats {
+        std::size_t   queueDepth;
+        std::uint64_t written;        // rows written
+        std::uint64_t failed;         // rows lost with a batch that could not be written
+        std::uint64_t coalesced;      // records dropped as superseded
+        std::uint64_t batches;        // transactions committed
+        std::uint64_t lastLatencyUs;  // enqueue -> commit, oldest record of last batch
+        std::uint64_t maxLatencyUs;
+    };
+
+    explicit AsyncWriter(std::size_t capacity = 4096);
+    ~AsyncWriter();                   // drains and stops
+
+    bool start(std::unique_ptr<Storage> storage);   // a handle from Storage::openWriter()
+    void push(int habitId, date::Day day, bool done);
+    void drain();                     // wait until everything queued is committed
+    void stop();                      // drain, then join the worker
+    Stats stats() const;
+
+private:
+    struct Op {
+        int habitId;
+        date::Day day;
+        bool done;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    static constexpr int kAttempts = 3;
+
+    void run();
+    void writeBatch(std::vector<Op>& batch);
+
+    std::size_t capacity_;
+    mutable std::mutex mu_;
+    std::condition_variable notEmpty_, notFull_, idle_;
+    std::deque<Op> queue_;
+    bool stopping_ = false;
+    bool busy_ = false;               // worker holds a batch not yet committed
+    std::thread thread_;
+
+    std::unique_ptr<Storage> storage_;
+
+    std::atomic<std::uint64_t> written_{0}, failed_{0}, coalesced_{0}, batches_{0};
+    std::atomic<std::uint64_t> lastLatencyUs_{0}, maxLatencyUs_{0};
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Headless command mode: `habit_tracker <command> [options]` runs without
+// any UI, applies every command in one DB transaction and prints one compact
+// JSON object per command (JSON Lines), so scripts can drive thousands of
+// operations from one process.
+//
+//   add    --habit NAME
+//   mark   --habit NAME [--date YYYY-MM-DD]      default: today
+//   unmark --habit NAME [--date YYYY-MM-DD]
+//   mark|unmark --habit NAME --from D --to D     a range in one step; "changed"
+//                                                is the number of days changed
+//   list                                         streak and today's state per habit
+//   report [--habit NAME] [--from D] [--to D]    stats, default the last 7 days
+//   batch                                        commands from stdin, one per line;
+//                                                "#" lines and blank lines are skipped
+//
+// On the command line only: --db PATH, --storage sqlite|log, --format json.
+// Every output line has "cmd" and "ok" (plus "error" when ok is false);
+// batch ends with a summary line.
+namespace cli {
+
+bool isCommand(const char* arg);
+
+// args[0] is the command. Returns the exit code: 0 if every command
+// succeeded, 1 if any failed, 2 for a bad invocation.
+int run(const std::vector<std::string>& args, std::istream& in, std::ostream& out);
+
+} // namespace cli
@@ -0,0 +1,104 @@
+#pragma once
+#include "Date.h"
+#include "Pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packed set of completed days: one bit per day, 64 days per word.
+// Bit 0 of words_[0] is day base_ (always a multiple of 64).
+class CompletionBitmap {
+public:
+    bool test(date::Day d) const;
+    bool set(date::Day d);              // returns true if the bit changed
+    bool reset(date::Day d);            // returns true if the bit changed
+    // [from, to], a word at a time; both return the bits changed and, if
+    // `changed` is given, append those days to it in order
+    int setRange(date::Day from, date::Day to, std::vector<date::Day>* changed = nullptr);
+    int resetRange(date::Day from, date::Day to, std::vector<date::Day>* changed = nullptr);
+    // OR in n packed words, bit i of words[k] being day base + 64k + i (base
+    // a multiple of 64); returns the bits changed
+    int setWords(date::Day base, const std::uint64_t* words, std::size_t n);
+
+    std::size_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    date::Day first() const;            // earliest completed day (requires !empty())
+    date::Day last() const;             // latest completed day   (requires !empty())
+
+    // bounds of the run of consecutive completed days containing d (requires test(d))
+    date::Day runStart(date::Day d) const;
+    date::Day runEnd(date::Day d) const;
+    int longestRun() const;
+    int longestRun(date::Day from, date::Day to) const;          // runs clipped to [from, to]
+
+    // bulk range queries, whole words at a time
+    int count(date::Day from, date::Day to) const;                // completions in [from, to]
+    std::uint64_t window(date::Day from, int n) const;            // bit i = test(from + i), n <= 64
+
+    // memory held by the bit storage
+    std::size_t memoryBytes() const { return words_.capacity() * sizeof(std::uint64_t); }
+
+    // call f(day) for every completed day, oldest first
+    template <typename F>
+    void forEach(F&& f) const {
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            std::uint64_t bits = words_[w];
+            while (bits) {
+                int b = __builtin_ctzll(bits);
+                f(static_cast<date::Day>(base_ + static_cast<date::Day>(w * 64) + b));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // call f(day) for every completed day in [from, to], oldest first
+    template <typename F>
+    void forEachIn(date::Day from, date::Day to, F&& f) const {
+        forEachWord(from, to, [&](std::uint64_t bits, date::Day shift) {
+            while (bits) {
+                f(static_cast<date::Day>(from + shift + __builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        });
+    }
+
+private:
+    date::Day base_ = 0;
+    std::vector<std::uint64_t, pool::Allocator<std::uint64_t>> words_;
+    std::size_t count_ = 0;
+
+    static date::Day wordBase(date::Day d) { return d - ((d % 64) + 64) % 64; }
+
+    void cover(date::Day from, date::Day to);   // grow the words to hold [from, to]
+    // append the days of word w's `bits` to out
+    void appendDays(std::size_t w, std::uint64_t bits, std::vector<date::Day>* out) const {
+        if (!out) return;
+        for (; bits; bits &= bits - 1)
+            out->push_back(base_ + static_cast<date::Day>(w * 64) + __builtin_ctzll(bits));
+    }
+
+    // bits of word w that fall in [from, to]
+    std::uint64_t rangeMask(std::size_t w, date::Day from, date::Day to) const {
+        date::Day wb = base_ + static_cast<date::Day>(w * 64);
+        std::uint64_t mask = ~std::uint64_t{0};
+        if (from > wb) mask &= ~std::uint64_t{0} << (from - wb);
+        if (to - wb < 63) mask &= (std::uint64_t{2} << (to - wb)) - 1;
+        return mask;
+    }
+
+    // f(bits, shift) for every word overlapping [from, to], bits masked to
+    // the range; shift is the day of the word's bit 0 minus `from`
+    template <typename F>
+    void forEachWord(date::Day from, date::Day to, F&& f) const {
+        if (words_.empty() || to < from) return;
+        date::Day lo = from > base_ ? from : base_;
+        for (std::size_t w = static_cast<std::size_t>(lo - base_) / 64; w < words_.size(); ++w) {
+            date::Day wb = base_ + static_cast<date::Day>(w * 64);
+            if (wb > to) return;
+            std::uint64_t bits = words_[w];
+            if (from > wb) bits &= ~std::uint64_t{0} << (from - wb);
+            if (to - wb < 63) bits &= (std::uint64_t{2} << (to - wb)) - 1;
+            if (bits) f(bits, wb - from);
+        }
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Calendar days as plain integers (days since 1970-01-01).
+namespace date {
+
+using Day = std::int32_t;
+
+struct Civil {
+    int      year;
+    unsigned month;   // 1..12
+    unsigned day;     // 1..31
+};
+
+// days_from_civil / civil_from_days (proleptic Gregorian calendar)
+constexpr Day fromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<Day>(era * 146097 + static_cast<int>(doe) - 719468);
+}
+
+constexpr Civil toCivil(Day z) {
+    const int zz = z + 719468;
+    const int era = (zz >= 0 ? zz : zz - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(zz - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    return Civil{static_cast<int>(yoe) + era * 400 + (m <= 2), m, d};
+}
+
+constexpr int weekday(Day d) {                     // 0 = Sunday ... 6 = Saturday
+    return d >= -4 ? (d + 4) % 7 : (d + 5) % 7 + 6;
+}
+
+static_assert(weekday(0) == 4, "1970-01-01 was a Thursday");
+static_assert(fromCivil(1970, 1, 1) == 0, "epoch must be day 0");
+static_assert(toCivil(fromCivil(2024, 2, 29)).day == 29, "leap day round-trip");
+
+std::string toISO(Day d);                          // "YYYY-MM-DD"
+bool parseISO(const std::string& s, Day& out);     // false on malformed input
+bool parseISO(const char* s, std::size_t n, Day& out);
+
+Day today();                                       // local calendar day, cached until midnight
+
+} // namespace date
@@ -0,0 +1,26 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+// inotify watch on one store: `path` and the siblings that share its name as
+// a prefix (SQLite's -wal and -journal files). The directory is watched, so
+// files created later are covered. Without inotify, wait() just times out
+// and callers fall back to polling.
+class FileWatcher {
+public:
+    explicit FileWatcher(const std::string& path);
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool watching() const { return fd_ >= 0; }
+
+    // true once one of the files was written; false on timeout or wake()
+    bool wait(std::chrono::milliseconds timeout);
+    void wake();                    // from another thread: ends the current (or next) wait()
+
+private:
+    int fd_ = -1;                   // inotify
+    int wakeFd_ = -1;               // eventfd
+    std::string name_;              // file name prefix
+};
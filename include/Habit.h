@@ -1,22 +1,55 @@
 #pragma once
+#include "CompletionBitmap.h"
+#include "Date.h"
+#include <cstdint>
 #include <string>
-#include <set>
+#include <string_view>
+#include <vector>
 #include <nlohmann/json_fwd.hpp>
 
 class Habit {
 private:
-    std::string name_;
-    std::set<std::string> completedDates_;   // "YYYY-MM-DD"
+    std::string_view name_;                   // interned, see pool::intern
+    CompletionBitmap completed_;              // one bit per calendar day
+
+    // streak state, kept up to date by setCompletedOn
+    date::Day runStart_ = 0;                  // first day of the run ending at runEnd_
+    date::Day runEnd_ = 0;                    // last completed day
+    int longest_ = 0;                         // longest run ever
+    std::uint32_t revision_ = 0;              // bumped on every change
+
+    void onSet(date::Day day);
+    void onReset(date::Day day);
+    void onSetRange(date::Day from, date::Day to, bool wasEmpty);
+    void onResetRange(date::Day from, date::Day to, bool wasLongest);
 
 public:
-    explicit Habit(const std::string& habitName);
+    explicit Habit(std::string_view habitName);
 
     void markCompleteToday();
     void unmarkToday();                       // toggle off today
-    bool isCompletedOn(const std::string& date) const;
+    void setCompletedOn(date::Day day, bool done);
+    // many days in one step; both return how many days changed. Ranges
+    // longer than kMaxRangeDays are refused (0); `changed`, if given, gets
+    // the days that flipped, oldest first.
+    static constexpr int kMaxRangeDays = 100 * 366;
+    int  setCompletedRange(date::Day from, date::Day to, bool done,
+                           std::vector<date::Day>* changed = nullptr);   // [from, to]
+    int  setCompletedDays(std::vector<date::Day> days, bool done);      // any order, duplicates ok
+    // packed words as stored (see CompletionBitmap::setWords); streaks are
+    // rebuilt once per call, so loading costs one pass over the words
+    int  setCompletedWords(date::Day base, const std::uint64_t* words, std::size_t n);
+    bool isCompletedOn(date::Day day) const { return completed_.test(day); }
+    bool isCompletedOn(const std::string& iso) const;    // "YYYY-MM-DD"
 
-    int  currentStreak() const;               // compute from completedDates_
-    std::string getName() const;
+    int  currentStreak() const;               // run of days ending today
+    int  currentStreak(date::Day today) const;
+    int  longestStreak() const { return longest_; }
+    bool hasCompletions() const { return !completed_.empty(); }
+    date::Day lastCompletion() const { return runEnd_; }   // valid if hasCompletions()
+    std::string_view getName() const { return name_; }   // valid for the life of the process
+    const CompletionBitmap& completions() const { return completed_; }
+    std::uint32_t revision() const { return revision_; }  // lets views cache per habit
 
     nlohmann::json toJson() const;
     static Habit fromJson(const nlohmann::json& j);
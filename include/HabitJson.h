@@ -0,0 +1,27 @@
+#pragma once
+#include "Habit.h"
+#include <functional>
+#include <iosfwd>
+
+// Streaming reader/writer for the JSON export format:
+//   [ {"dates": ["YYYY-MM-DD", ...], "name": "..."}, ... ]
+// Neither side holds more than one habit in memory at a time.
+
+class HabitJsonWriter {
+public:
+    HabitJsonWriter(std::ostream& out, bool compact);
+    void write(const Habit& h);
+    void finish();                        // closes the top-level array
+
+private:
+    std::ostream& out_;
+    bool compact_;
+    bool first_ = true;
+};
+
+// SAX-parse `in`, calling onHabit for every habit object as soon as it closes.
+// Returns false on malformed input (habits already delivered are kept).
+bool readHabitJson(std::istream& in, const std::function<void(Habit&&)>& onHabit);
+
+// Same, over the in-memory text [first, last).
+bool readHabitJson(const char* first, const char* last, const std::function<void(Habit&&)>& onHabit);
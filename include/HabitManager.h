@@ -1,42 +1,202 @@
 #pragma once
 #include "Habit.h"
+#include "HabitSnapshot.h"
+#include "Analytics.h"
+#include "AsyncWriter.h"
+#include "FileWatcher.h"
+#include "Import.h"
+#include "Storage.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <string>
-#include <sqlite3.h>
+#include <string_view>
+#include <unordered_map>
 
+// Safe to share between threads. Writers are serialized and publish a new
+// HabitSnapshot when each call returns; readers work on whichever snapshot
+// they took and never block a writer.
 class HabitManager {
 public:
     HabitManager();                       // constructor
     ~HabitManager();                      // destructor
 
-    // open a database file (call this at startup)
-    bool openDB(const std::string& path);
+    // open a database file (call this at startup); Backend::Log keeps an
+    // append-only event log instead of a SQLite database
+    bool openDB(const std::string& path, Backend backend = Backend::Sqlite);
 
-    void addHabit(const std::string& name);
-    bool markCompleteToday(const std::string& name);
+    void addHabit(std::string_view name);
+    bool addHabit(Habit habit);           // prebuilt habit with history; false if the name exists
+    // many prebuilt habits, published once and written in one transaction
+    // (or the open batch); names already present are skipped. Returns the
+    // number added.
+    std::size_t addHabits(std::vector<Habit> habits);
+    bool markCompleteToday(std::string_view name);
     void list() const;
-    void weeklyReport() const;
+    void weeklyReport(int weeks = 1) const;
     bool loadFromDB(); 
 
+    // apply what other processes wrote to the DB since the last load or
+    // refresh: only the changed days, or a full reload if the store's change
+    // feed no longer covers the gap. Returns true if habits changed.
+    bool refreshFromDB();
+
+    // watch the DB file on a background thread and refresh as soon as another
+    // process commits; onChange runs on that thread after each refresh that
+    // changed something. Returns false if the backend has no change feed.
+    bool startWatching(std::function<void()> onChange);
+    void stopWatching();
+
+    // analytics over the inclusive day range [from, to]; parallel over habits
+    std::vector<HabitStats> stats(date::Day from, date::Day to) const;
+    static std::vector<HabitStats> stats(const HabitSnapshot& habits, date::Day from, date::Day to);
+    bool heatmap(std::string_view name, int year, YearHeatmap& out) const;
+
     // keep JSON save/load if you want to export
-    bool save(const std::string& path) const;
+    bool save(const std::string& path, bool compact = false) const;
     bool load(const std::string& path);
 
-    // toggle today's completion
-    bool setToday(const std::string& name, bool done);
+    // bulk import of a JSON export or CSV history, parsed in parallel and
+    // merged into the existing habits (nothing is cleared); new completions
+    // are written to the DB in large transactions
+    bool importFile(const std::string& path, const ImportOptions& opts = ImportOptions(),
+                    ImportStats* stats = nullptr);
+
+    // toggle today's completion; false if the habit is missing or the
+    // handle is from an older generation
+    bool setToday(std::string_view name, bool done);
+    bool setToday(HabitHandle habit, bool done);
+    bool setCompletedOn(HabitHandle habit, date::Day day, bool done);   // any day
+
+    // backfill or clear many days at once: one copy of the habit, streaks
+    // updated incrementally, one DB transaction (or a share of the open
+    // batch). Return the number of days that changed, -1 for a stale handle
+    // or a range longer than Habit::kMaxRangeDays.
+    int setCompletedRange(HabitHandle habit, date::Day from, date::Day to, bool done);   // [from, to]
+    int setCompletedDays(HabitHandle habit, std::vector<date::Day> days, bool done);
 
-    // expose habits to the UI
-    const std::vector<Habit>& getHabits() const;
+    // group DB writes into one transaction (opened right away), committed
+    // after maxOps writes, on flush()/endBatch(), or by a timer thread once
+    // it has been open for maxDelay (so the last writes of a burst do not
+    // wait for the next write)
+    void beginBatch(std::size_t maxOps = 1000,
+                    std::chrono::milliseconds maxDelay = std::chrono::milliseconds(500));
+    void endBatch();
+    void flush();
+    bool flushIfDue();                    // commit if the batch is older than maxDelay
+
+    // move completion writes to a background thread (own DB connection);
+    // stopAsyncWriter() drains the queue, the destructor does too. Returns
+    // false if the backend has no second handle to write through.
+    bool startAsyncWriter();
+    void stopAsyncWriter();
+    AsyncWriter::Stats asyncWriterStats() const;
+
+    // expose habits to the UI and other readers
+    HabitSnapshot getHabits() const;                                   // the current version
+    std::shared_ptr<const Habit> find(std::string_view name) const;    // nullptr if missing
+    HabitHandle handleOf(std::string_view name) const;                 // kNoHabit if missing
+    std::uint32_t generation() const { return getHabits().generation(); }
+
+    // Per-thread read handle: get() re-fetches the snapshot only after a
+    // writer has published, so steady-state reads are one atomic load.
+    class Reader {
+    public:
+        explicit Reader(const HabitManager& manager) : manager_(manager) {}
+        const HabitSnapshot& get();
+
+    private:
+        const HabitManager& manager_;
+        std::uint64_t seen_ = ~std::uint64_t{0};
+        HabitSnapshot snapshot_;
+    };
 
 private:
-    std::vector<Habit> habits_;
+    using Version = HabitSnapshot::Data;
+
+    // published state: current_ changes only under both mutexes, so holding
+    // writeMu_ is enough to read it
+    mutable std::recursive_mutex writeMu_;       // one writer call at a time (calls may nest)
+    mutable std::mutex publishMu_;               // guards current_ for the pointer copy/swap
+    std::shared_ptr<const Version> current_;
+    std::atomic<std::uint64_t> published_{0};    // bumped after every swap
+
+    // writer-side state, guarded by writeMu_
+    std::shared_ptr<Version> draft_;             // next version, null until the first edit
+    std::vector<int> ids_;                       // storage id per slot, -1 = unknown
+
+    // RAII writer section: takes writeMu_, publishes any draft on exit
+    class WriteLock {
+    public:
+        explicit WriteLock(HabitManager& m) : m_(m), lock_(m.writeMu_) {}
+        ~WriteLock() { m_.publish(); }
+
+    private:
+        HabitManager& m_;
+        std::lock_guard<std::recursive_mutex> lock_;
+    };
+
+    const Version& latest() const { return draft_ ? *draft_ : *current_; }
+    Version& edit();                             // draft_, started from current_ if needed
+    Habit& editHabit(std::size_t slot);          // copy-on-write: cloned if a snapshot shares it
+    const Habit& habitAt(std::size_t slot) const;   // in the latest version, read-only
+    void publish();
+
+    std::unique_ptr<Storage> storage_;      // set by openDB
+    std::unique_ptr<AsyncWriter> writer_;   // set while the async writer runs
+
+    // change feed position and storage id -> slot, for refreshFromDB
+    std::int64_t changeCursor_ = 0;
+    std::unordered_map<int, std::size_t> slotById_;
+
+    // watch thread; not guarded by writeMu_ (the thread takes it to refresh)
+    std::unique_ptr<FileWatcher> watcher_;
+    std::thread watchThread_;
+    std::atomic<bool> watchStop_{false};
+
+    // write batching state
+    bool batching_ = false;
+    bool inTxn_ = false;
+    std::size_t pending_ = 0;
+    std::size_t batchMaxOps_ = 1000;
+    std::chrono::milliseconds batchMaxDelay_{500};
+    std::chrono::steady_clock::time_point batchStart_;
+    // commits a batch once it is maxDelay old; timerMu_ guards the two
+    // fields below and is only ever taken after writeMu_, never before
+    std::thread batchTimer_;
+    std::mutex timerMu_;
+    std::condition_variable timerCv_;
+    bool timerRunning_ = false;
+    std::chrono::steady_clock::time_point batchDeadline_ = std::chrono::steady_clock::time_point::max();
+
+    void startTxn();
+    void armBatchTimer();
+    void batchTimerLoop();
+    void stopBatchTimer();
+
+    void writeCompletion(int habit_id, date::Day day, bool done);
+    void writeCompletions(int habit_id, const std::vector<date::Day>& days, bool done);
 
-    // NEW: SQLite database handle
-    sqlite3* db_ = nullptr;
+    std::size_t slotOf(std::string_view name) const;       // npos if missing
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
 
-    Habit* find(const std::string& name);
-    const Habit* find(const std::string& name) const;
+    void setSlot(std::size_t slot, date::Day day, bool done);
+    void addSlot(std::string_view name, int id);
+    void adoptSlot(Habit&& habit, int id);
+    void clearSlots();
+    void setId(std::size_t slot, int id);
+    void indexName(std::string_view name, std::size_t slot);
+    void reserveIndex(std::size_t names);
+    bool reloadFromStorage();
+    void mergeImported(ImportChunk&& chunk, ImportStats& stats);
+    int insertHabitRow(std::string_view name);             // storage id, -1 if none
 
-    // helper to get habit id from DB (will implement in .cpp)
-    int getHabitId(const std::string& name);
+    // storage id of a slot; looked up once and cached if not known yet
+    int habitId(std::size_t slot);
 };
@@ -0,0 +1,127 @@
+#pragma once
+#include "Habit.h"
+#include "Pool.h"
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Stable integer name for a habit: generation in the high 32 bits, slot in
+// the low 32. Slots are never reordered or reused, so a handle names the same
+// habit in every version until the habits are replaced (a load bumps the
+// generation and old handles stop resolving).
+using HabitHandle = std::uint64_t;
+constexpr HabitHandle kNoHabit = ~HabitHandle{0};
+
+// One published version of HabitManager's habits. Immutable and cheap to
+// copy (one shared pointer): writers build the next version beside it and
+// swap it in, so a snapshot stays consistent for as long as it is held.
+class HabitSnapshot {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Habit;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Habit*;
+        using reference = const Habit&;
+
+        const_iterator(const HabitSnapshot& s, std::size_t i) : s_(&s), i_(i) {}
+        reference operator*() const { return (*s_)[i_]; }
+        pointer operator->() const { return &(*s_)[i_]; }
+        const_iterator& operator++() { ++i_; return *this; }
+        bool operator==(const const_iterator& o) const { return i_ == o.i_; }
+        bool operator!=(const const_iterator& o) const { return i_ != o.i_; }
+
+    private:
+        const HabitSnapshot* s_;
+        std::size_t i_;
+    };
+
+    HabitSnapshot() = default;
+
+    std::size_t size() const { return data_ ? data_->size : 0; }
+    bool empty() const { return size() == 0; }
+    const Habit& operator[](std::size_t i) const { return *slot(i); }
+    const_iterator begin() const { return const_iterator(*this, 0); }
+    const_iterator end() const { return const_iterator(*this, size()); }
+
+    // nullptr if missing; valid while this snapshot (or a copy) is alive
+    const Habit* find(std::string_view name) const {
+        std::size_t i = indexOf(name);
+        return i == npos ? nullptr : slot(i).get();
+    }
+    // keeps one habit alive independently of the snapshot
+    std::shared_ptr<const Habit> share(std::size_t i) const { return slot(i); }
+
+    std::uint32_t generation() const { return data_ ? data_->generation : 0; }   // bumped when habits are replaced
+
+    HabitHandle handle(std::size_t i) const { return std::uint64_t{generation()} << 32 | i; }
+    HabitHandle handleOf(std::string_view name) const {
+        std::size_t i = indexOf(name);
+        return i == npos ? kNoHabit : handle(i);
+    }
+    // nullptr if the handle is from another generation or past the end
+    const Habit* get(HabitHandle h) const {
+        std::size_t i = slotOf(h, generation(), size());
+        return i == npos ? nullptr : slot(i).get();
+    }
+
+private:
+    friend class HabitManager;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Slots live in fixed-size chunks so a new version copies the chunk table
+    // and the one chunk it edits, not every slot. Versions share every chunk,
+    // habit and index they did not change; the writer copies before editing.
+    // All of it comes from the habit pool.
+    static constexpr std::size_t kChunk = 64;
+    using HabitPtr = std::shared_ptr<Habit>;
+    using Chunk = std::vector<HabitPtr, pool::Allocator<HabitPtr>>;
+    using Shard = std::unordered_map<std::string_view, std::size_t>;   // interned name -> slot
+
+    // The name index is split by hash into small shards, so adding a name
+    // copies the shard table and one shard rather than every name. The
+    // writer doubles the shard count (a power of two) whenever the average
+    // shard would pass kShardLoad names.
+    static constexpr std::size_t kShardLoad = 32;
+    struct Index {
+        std::vector<std::shared_ptr<Shard>, pool::Allocator<std::shared_ptr<Shard>>> shards;
+        std::size_t size = 0;
+
+        static std::size_t hash(std::string_view name) { return std::hash<std::string_view>()(name); }
+        std::size_t shardOf(std::string_view name) const { return hash(name) & (shards.size() - 1); }
+
+        std::size_t find(std::string_view name) const {
+            if (shards.empty()) return npos;
+            const Shard& shard = *shards[shardOf(name)];
+            auto it = shard.find(name);
+            return it == shard.end() ? npos : it->second;
+        }
+    };
+
+    struct Data {
+        std::vector<std::shared_ptr<Chunk>, pool::Allocator<std::shared_ptr<Chunk>>> chunks;
+        std::size_t size = 0;
+        std::shared_ptr<Index> index;
+        std::uint32_t generation = 0;
+    };
+
+    explicit HabitSnapshot(std::shared_ptr<const Data> data) : data_(std::move(data)) {}
+
+    const HabitPtr& slot(std::size_t i) const { return (*data_->chunks[i / kChunk])[i % kChunk]; }
+
+    std::size_t indexOf(std::string_view name) const {
+        return data_ ? data_->index->find(name) : npos;
+    }
+
+    static std::size_t slotOf(HabitHandle h, std::uint32_t generation, std::size_t size) {
+        std::size_t i = static_cast<std::uint32_t>(h);
+        return h >> 32 == generation && i < size ? i : npos;
+    }
+
+    std::shared_ptr<const Data> data_;
+};
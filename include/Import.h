@@ -0,0 +1,64 @@
+#pragma once
+#include "Habit.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Bulk import of large histories. The file is memory-mapped, cut into chunks
+// on record boundaries and parsed on a pool of worker threads; chunks come
+// back in file order on the calling thread, so merging overlaps parsing.
+//
+//   JSON  the export shape: [ {"name": "...", "dates": ["YYYY-MM-DD", ...]}, ... ]
+//   CSV   one completion per line: name,date[,done]. A header line is skipped,
+//         names may be double-quoted ("" escapes a quote, no embedded newlines),
+//         dates may carry a time (2024-03-01T08:00:00) and rows whose done
+//         column is 0/false/no are ignored.
+
+enum class ImportFormat { Auto, Json, Csv };   // Auto: .csv extension, else sniff for '['
+
+struct ImportProgress {
+    std::uint64_t bytesDone;
+    std::uint64_t bytesTotal;
+    std::uint64_t rows;                 // completions parsed so far
+    double seconds;
+};
+
+struct ImportOptions {
+    ImportFormat format = ImportFormat::Auto;
+    unsigned threads = 0;               // parser threads, 0 = one per core
+    std::size_t chunkBytes = 8u << 20;
+    std::size_t batchRows = 100000;     // DB writes per transaction
+    std::chrono::milliseconds progressEvery{250};
+    std::function<void(const ImportProgress&)> onProgress;   // on the importing thread
+};
+
+struct ImportStats {
+    std::uint64_t bytes = 0;
+    std::uint64_t rows = 0;             // completion rows parsed
+    std::uint64_t added = 0;            // completions that were new
+    std::uint64_t duplicates = 0;       // repeated in the file or already present
+    std::uint64_t badRows = 0;          // CSV lines that did not parse
+    std::uint64_t habitsAdded = 0;
+    std::uint64_t habitsMerged = 0;     // existing habits that gained history
+    double seconds = 0.0;
+
+    double mbPerSec() const { return seconds > 0 ? static_cast<double>(bytes) / 1e6 / seconds : 0.0; }
+    double rowsPerSec() const { return seconds > 0 ? static_cast<double>(rows) / seconds : 0.0; }
+};
+
+// One parsed chunk; a habit name appears at most once per chunk.
+struct ImportChunk {
+    std::vector<Habit> habits;
+    std::uint64_t bytes = 0;
+    std::uint64_t rows = 0;
+    std::uint64_t duplicates = 0;
+    std::uint64_t badRows = 0;
+};
+
+// Parse `path`, handing every chunk to onChunk in file order. Fills the
+// parse-side fields of stats. Returns false if the file cannot be read or the
+// JSON is malformed (chunks already delivered stay delivered).
+bool parseImport(const std::string& path, const ImportOptions& opts, ImportStats& stats,
+                 const std::function<void(ImportChunk&&)>& onChunk);
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only mapping of a whole file, unmapped on destruction. Empty or
+// unreadable files map to nothing (data() == nullptr).
+class MappedFile {
+public:
+    explicit MappedFile(int fd);
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+
+    void map(int fd);
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hot-path instrumentation: per-thread counters with fixed log2 latency
+// buckets, aggregated on demand. Build with HABIT_METRICS=0 to compile every
+// HABIT_TIMER / HABIT_COUNT site out.
+#ifndef HABIT_METRICS
+#define HABIT_METRICS 1
+#endif
+
+namespace metrics {
+
+enum Id {
+    kDbPrepare,
+    kDbStep,
+    kDbCommit,
+    kDbLoad,
+    kLookup,
+    kStreakQuery,
+    kStreakRescan,
+    kJsonSave,
+    kJsonLoad,
+    kFrame,
+    kCount
+};
+
+constexpr int kBuckets = 40;      // bucket b holds latencies in [2^b, 2^(b+1)) ns
+
+struct Summary {
+    const char* name;
+    std::uint64_t count;
+    std::uint64_t bytes;
+    double meanNs;
+    double p50Ns;                 // upper edge of the bucket holding the percentile
+    double p99Ns;
+};
+
+void record(Id id, std::uint64_t ns, std::uint64_t bytes = 0);
+std::vector<Summary> snapshot();                  // summed over all threads
+bool dump(const std::string& path);               // JSON, one entry per metric
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Id id, std::uint64_t bytes = 0)
+        : id_(id), bytes_(bytes), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        record(id_, static_cast<std::uint64_t>(ns), bytes_);
+    }
+    void addBytes(std::uint64_t n) { bytes_ += n; }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Id id_;
+    std::uint64_t bytes_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace metrics
+
+#define HABIT_METRICS_CAT2(a, b) a##b
+#define HABIT_METRICS_CAT(a, b) HABIT_METRICS_CAT2(a, b)
+
+#if HABIT_METRICS
+// time the rest of the enclosing scope
+#define HABIT_TIMER(id) metrics::ScopedTimer HABIT_METRICS_CAT(habit_timer_, __LINE__)(metrics::id)
+// named timer, for sites that add byte counts
+#define HABIT_TIMER_NAMED(var, id) metrics::ScopedTimer var(metrics::id)
+#define HABIT_TIMER_BYTES(var, n) (var).addBytes(n)
+// count an event without timing it
+#define HABIT_COUNT(id) metrics::record(metrics::id, 0)
+#else
+#define HABIT_TIMER(id) ((void)0)
+#define HABIT_TIMER_NAMED(var, id) ((void)0)
+#define HABIT_TIMER_BYTES(var, n) ((void)0)
+#define HABIT_COUNT(id) ((void)0)
+#endif
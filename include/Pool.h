@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+// Arena storage for habit data.
+//
+// allocate()/deallocate() serve the small blocks every habit version is made
+// of (habits, chunks, version records, bitmap words) from per-size free lists
+// carved out of 64 KiB slabs. Slabs are kept for reuse, never returned to the
+// system; blocks above 16 KiB go straight to operator new. Thread-safe, since
+// a version built by the writer is usually freed by a reader dropping it.
+//
+// intern() keeps one copy of every distinct habit name for the life of the
+// process, so habits and indexes hold string_views instead of strings.
+namespace pool {
+
+void* allocate(std::size_t bytes);
+void deallocate(void* p, std::size_t bytes) noexcept;
+
+std::string_view intern(std::string_view name);
+
+// std-style allocator over allocate()/deallocate()
+template <typename T>
+struct Allocator {
+    using value_type = T;
+
+    Allocator() = default;
+    template <typename U>
+    Allocator(const Allocator<U>&) {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(pool::allocate(n * sizeof(T))); }
+    void deallocate(T* p, std::size_t n) noexcept { pool::deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const Allocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const Allocator<U>&) const { return false; }
+};
+
+} // namespace pool
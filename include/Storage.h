@@ -0,0 +1,73 @@
+#pragma once
+#include "Date.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Persistence backend behind HabitManager. Ids are assigned by the backend;
+// writes outside begin()/commit() are applied on their own.
+class Storage {
+public:
+    // receives the stored state from loadAll()
+    struct Sink {
+        virtual ~Sink() = default;
+        virtual void reserve(std::size_t habits) { (void)habits; }
+        virtual void habit(int id, const std::string& name) = 0;
+        virtual void completion(int id, date::Day day) = 0;    // directly after habit(id)
+        // a habit's days packed as in CompletionBitmap::setWords, for backends
+        // that store them that way; by default fed to completion() one by one
+        virtual void completionWords(int id, date::Day base, const std::uint64_t* words, std::size_t n) {
+            for (std::size_t k = 0; k < n; ++k)
+                for (std::uint64_t bits = words[k]; bits; bits &= bits - 1)
+                    completion(id, base + static_cast<date::Day>(k * 64) + __builtin_ctzll(bits));
+        }
+    };
+
+    // receives changes made through other connections, oldest first
+    struct ChangeSink {
+        virtual ~ChangeSink() = default;
+        virtual void habit(int id, const std::string& name) = 0;
+        virtual void completion(int id, date::Day day, bool done) = 0;
+    };
+
+    virtual ~Storage() = default;
+
+    virtual bool open(const std::string& path) = 0;
+    virtual bool loadAll(Sink& sink) = 0;
+
+    virtual int addHabit(const std::string& name) = 0;         // new id, -1 if not added
+    virtual int findHabitId(const std::string& name) = 0;      // -1 if unknown
+    // these three return false when the write did not happen (locked past
+    // the busy timeout, disk full, ...); after a failure inside a
+    // transaction, rollback() ends it
+    virtual bool setCompletion(int habitId, date::Day day, bool done) = 0;
+    virtual bool begin() = 0;
+    virtual bool commit() = 0;
+    virtual void rollback() = 0;
+    // large imports: transactions may be recorded coarsely in the change feed
+    virtual void setBulk(bool on) { (void)on; }
+
+    // a second handle on the same store for a background writer, or nullptr
+    // if the backend is cheap enough to write from the caller's thread
+    virtual std::unique_ptr<Storage> openWriter() = 0;
+
+    virtual const char* name() const = 0;
+
+    // Change feed, for picking up writes other processes make to the store.
+    // Backends without one keep these defaults and are never watched.
+    virtual std::string watchPath() const { return std::string(); }   // file to watch, "" if none
+    virtual bool externallyChanged() { return false; }    // another connection committed since the last call
+    virtual std::int64_t changeCursor() { return 0; }     // feed position; take it before loadAll()
+    // deliver the changes after `cursor` and advance it; false if the feed no
+    // longer reaches back that far or holds a change it cannot express, and
+    // the caller has to reload everything
+    virtual bool readChanges(std::int64_t& cursor, ChangeSink& sink) {
+        (void)cursor; (void)sink;
+        return false;
+    }
+};
+
+enum class Backend { Sqlite, Log };
+
+std::unique_ptr<Storage> makeSqliteStorage();   // SqliteStorage.cpp
+std::unique_ptr<Storage> makeLogStorage();      // LogStorage.cpp: mmap'd append-only log
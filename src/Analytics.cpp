@@ -0,0 +1,53 @@
+#include "Analytics.h"
+#include <algorithm>
+#include <thread>
+
+HabitStats habitStats(const Habit& h, date::Day from, date::Day to) {
+    HabitStats s;
+    s.name = h.getName();
+    s.days = to >= from ? to - from + 1 : 0;
+    h.completions().forEachIn(from, to, [&](date::Day d) {
+        ++s.completed;
+        ++s.byWeekday[date::weekday(d)];
+    });
+    s.rate = s.days ? static_cast<double>(s.completed) / s.days : 0.0;
+    s.currentStreak = h.currentStreak(to);
+    s.longestStreak = h.longestStreak();
+    return s;
+}
+
+YearHeatmap yearHeatmap(const Habit& h, int year) {
+    YearHeatmap m;
+    m.year = year;
+    date::Day jan1 = date::fromCivil(year, 1, 1);
+    date::Day dec31 = date::fromCivil(year, 12, 31);
+    m.firstDay = jan1 - date::weekday(jan1);
+    m.weeks = (dec31 - m.firstDay) / 7 + 1;
+    m.cells.assign(static_cast<std::size_t>(m.weeks) * 7, YearHeatmap::kOutside);
+
+    for (date::Day d = jan1; d <= dec31; ++d)
+        m.cells[static_cast<std::size_t>(d - m.firstDay)] = YearHeatmap::kMissed;
+    h.completions().forEachIn(jan1, dec31, [&](date::Day d) {
+        m.cells[static_cast<std::size_t>(d - m.firstDay)] = YearHeatmap::kDone;
+    });
+    return m;
+}
+
+void parallelFor(std::size_t n, const std::function<void(std::size_t)>& f) {
+    const std::size_t kMinPerThread = 1024;
+    std::size_t threads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                (n + kMinPerThread - 1) / kMinPerThread);
+    if (threads <= 1) {
+        for (std::size_t i = 0; i < n; ++i) f(i);
+        return;
+    }
+    std::vector<std::thread> pool;
+    std::size_t chunk = (n + threads - 1) / threads;
+    for (std::size_t t = 0; t < threads; ++t) {
+        std::size_t begin = t * chunk, end = std::min(n, begin + chunk);
+        pool.emplace_back([&f, begin, end] {
+            for (std::size_t i = begin; i < end; ++i) f(i);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
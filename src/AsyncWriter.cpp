@@ -0,0 +1,114 @@
+#include "AsyncWriter.h"
+#include <iostream>
+#include <unordered_map>
+
+AsyncWriter::AsyncWriter(std::size_t capacity) : capacity_(capacity) {}
+
+AsyncWriter::~AsyncWriter() { stop(); }
+
+bool AsyncWriter::start(std::unique_ptr<Storage> storage) {
+    if (thread_.joinable()) return true;
+    if (!storage) return false;
+    storage_ = std::move(storage);
+    stopping_ = false;
+    thread_ = std::thread(&AsyncWriter::run, this);
+    return true;
+}
+
+void AsyncWriter::push(int habitId, date::Day day, bool done) {
+    std::unique_lock<std::mutex> lock(mu_);
+    notFull_.wait(lock, [&] { return queue_.size() < capacity_; });
+    queue_.push_back(Op{habitId, day, done, std::chrono::steady_clock::now()});
+    notEmpty_.notify_one();
+}
+
+void AsyncWriter::drain() {
+    std::unique_lock<std::mutex> lock(mu_);
+    if (!thread_.joinable()) return;
+    idle_.wait(lock, [&] { return queue_.empty() && !busy_; });
+}
+
+void AsyncWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!thread_.joinable()) return;
+        stopping_ = true;
+    }
+    notEmpty_.notify_one();
+    thread_.join();             // run() exits only once the queue is empty
+    storage_.reset();
+}
+
+AsyncWriter::Stats AsyncWriter::stats() const {
+    std::size_t depth;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        depth = queue_.size();
+    }
+    return Stats{depth, written_.load(), failed_.load(), coalesced_.load(), batches_.load(),
+                 lastLatencyUs_.load(), maxLatencyUs_.load()};
+}
+
+// ----------------- Worker -----------------
+
+void AsyncWriter::run() {
+    std::vector<Op> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            notEmpty_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;                 // stopping and drained
+            batch.assign(queue_.begin(), queue_.end());
+            queue_.clear();
+            busy_ = true;
+        }
+        notFull_.notify_all();
+
+        writeBatch(batch);
+
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            busy_ = false;
+        }
+        idle_.notify_all();
+    }
+}
+
+void AsyncWriter::writeBatch(std::vector<Op>& batch) {
+    // last record per (habit, day) wins; earlier toggles never reach the DB
+    std::unordered_map<std::uint64_t, std::size_t> latest;
+    latest.reserve(batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        std::uint64_t key = (std::uint64_t(std::uint32_t(batch[i].habitId)) << 32) |
+                            std::uint32_t(batch[i].day);
+        latest[key] = i;
+    }
+    coalesced_ += batch.size() - latest.size();
+
+    // the busy timeout already waited on a lock; the pause between attempts
+    // is for errors that clear up on their own
+    bool ok = false;
+    for (int attempt = 0; attempt < kAttempts && !ok; ++attempt) {
+        if (attempt) std::this_thread::sleep_for(std::chrono::milliseconds(100 << attempt));
+        ok = storage_->begin();
+        for (auto it = latest.begin(); ok && it != latest.end(); ++it) {
+            const Op& op = batch[it->second];
+            ok = storage_->setCompletion(op.habitId, op.day, op.done);
+        }
+        ok = ok && storage_->commit();
+        if (!ok) storage_->rollback();
+    }
+    if (!ok) {
+        failed_ += latest.size();
+        std::cerr << "Async writer: could not write " << latest.size() << " change(s) after "
+                  << kAttempts << " attempts\n";
+        return;
+    }
+
+    written_ += latest.size();
+    ++batches_;
+    auto us = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - batch.front().queued).count());
+    lastLatencyUs_ = us;
+    if (us > maxLatencyUs_) maxLatencyUs_ = us;
+}
@@ -0,0 +1,242 @@
+#include "Cli.h"
+#include "HabitManager.h"
+#include <nlohmann/json.hpp>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+using nlohmann::json;
+
+namespace cli {
+
+namespace {
+
+const char* const kCommands[] = {"add", "mark", "unmark", "list", "report", "batch"};
+
+// swallows HabitManager's progress messages so stdout stays machine-readable
+struct NullBuf : std::streambuf {
+    int overflow(int c) override { return c; }
+};
+
+struct Options {
+    std::string habit;
+    std::string date, from, to;
+    std::string db;                         // command line only; default per backend
+    Backend backend = Backend::Sqlite;      // command line only
+};
+
+// `--key value` pairs after the command word
+bool parseOptions(const std::vector<std::string>& args, bool commandLine, Options& o, std::string& error) {
+    for (std::size_t i = 1; i < args.size(); i += 2) {
+        const std::string& key = args[i];
+        if (i + 1 == args.size()) { error = "missing value for " + key; return false; }
+        const std::string& value = args[i + 1];
+        if (key == "--habit")     o.habit = value;
+        else if (key == "--date") o.date = value;
+        else if (key == "--from") o.from = value;
+        else if (key == "--to")   o.to = value;
+        else if (commandLine && key == "--db") o.db = value;
+        else if (commandLine && key == "--storage" && (value == "sqlite" || value == "log"))
+            o.backend = value == "log" ? Backend::Log : Backend::Sqlite;
+        else if (commandLine && key == "--format" && value == "json") {}
+        else { error = "bad option " + key + " " + value; return false; }
+    }
+    return true;
+}
+
+// shell-like words: whitespace separates them, double quotes group them
+// (\" and \\ escape inside quotes); false on an unterminated quote
+bool splitWords(const std::string& line, std::vector<std::string>& words) {
+    words.clear();
+    std::size_t i = 0, n = line.size();
+    for (;;) {
+        while (i < n && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+        if (i == n) return true;
+        std::string w;
+        while (i < n && !std::isspace(static_cast<unsigned char>(line[i]))) {
+            if (line[i] != '"') { w += line[i++]; continue; }
+            for (++i; i < n && line[i] != '"'; ++i) {
+                if (line[i] == '\\' && i + 1 < n) ++i;
+                w += line[i];
+            }
+            if (i == n) return false;
+            ++i;
+        }
+        words.push_back(std::move(w));
+    }
+}
+
+// Runs commands against one manager, one output line each.
+class Session {
+public:
+    Session(HabitManager& manager, std::ostream& out) : manager_(manager), reader_(manager), out_(out) {}
+
+    void exec(const std::string& cmd, const Options& o) {
+        ++commands_;
+        if (cmd == "add") add(o);
+        else if (cmd == "mark" || cmd == "unmark") mark(cmd, o, cmd == "mark");
+        else if (cmd == "list") list();
+        else if (cmd == "report") report(o);
+        else fail(cmd, "unknown command");
+    }
+
+    void batch(std::istream& in) {
+        auto t0 = std::chrono::steady_clock::now();
+        std::string line, error;
+        std::vector<std::string> words;
+        while (std::getline(in, line)) {
+            bool split = splitWords(line, words);
+            if (split && (words.empty() || words[0][0] == '#')) continue;
+            Options o;
+            if (!split) error = "unterminated quote";
+            else if (words[0] == "batch" || !isCommand(words[0].c_str())) error = "unknown command";
+            else if (parseOptions(words, false, o, error)) { exec(words[0], o); continue; }
+            ++commands_;
+            fail(split ? words[0] : "batch", error);
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        emit({{"cmd", "batch"}, {"ok", failed_ == 0}, {"commands", commands_}, {"failed", failed_},
+              {"seconds", secs}});
+    }
+
+    void fail(const std::string& cmd, const std::string& error) {
+        ++failed_;
+        emit({{"cmd", cmd}, {"ok", false}, {"error", error}});
+    }
+
+    std::size_t failed() const { return failed_; }
+
+private:
+    HabitManager& manager_;
+    HabitManager::Reader reader_;
+    std::ostream& out_;
+    std::size_t commands_ = 0;
+    std::size_t failed_ = 0;
+
+    void emit(const json& j) { out_ << j.dump() << '\n'; }
+
+    // empty text means `fallback`
+    static bool parseDay(const std::string& text, date::Day fallback, date::Day& day) {
+        if (text.empty()) { day = fallback; return true; }
+        return date::parseISO(text, day);
+    }
+
+    void add(const Options& o) {
+        if (o.habit.empty()) return fail("add", "missing --habit");
+        bool added = manager_.addHabit(Habit(o.habit));
+        emit({{"cmd", "add"}, {"ok", true}, {"habit", o.habit}, {"added", added}});
+    }
+
+    void mark(const std::string& cmd, const Options& o, bool done) {
+        if (o.habit.empty()) return fail(cmd, "missing --habit");
+        if (!o.from.empty() || !o.to.empty()) return markRange(cmd, o, done);
+        date::Day day;
+        if (!parseDay(o.date, date::today(), day)) return fail(cmd, "bad date " + o.date);
+        const HabitSnapshot& habits = reader_.get();
+        HabitHandle h = habits.handleOf(o.habit);
+        if (h == kNoHabit) return fail(cmd, "unknown habit " + o.habit);
+        bool changed = habits.get(h)->isCompletedOn(day) != done;
+        manager_.setCompletedOn(h, day, done);
+        emit({{"cmd", cmd}, {"ok", true}, {"habit", o.habit}, {"date", date::toISO(day)},
+              {"changed", changed}});
+    }
+
+    // --from D --to D, both required; the whole range is one update
+    void markRange(const std::string& cmd, const Options& o, bool done) {
+        if (!o.date.empty()) return fail(cmd, "--date with --from/--to");
+        if (o.from.empty() || o.to.empty()) return fail(cmd, o.from.empty() ? "missing --from" : "missing --to");
+        date::Day from, to;
+        if (!date::parseISO(o.from, from)) return fail(cmd, "bad date " + o.from);
+        if (!date::parseISO(o.to, to)) return fail(cmd, "bad date " + o.to);
+        if (from > to) return fail(cmd, "--from is after --to");
+        if (to - from >= Habit::kMaxRangeDays)
+            return fail(cmd, "range longer than " + std::to_string(Habit::kMaxRangeDays) + " days");
+        HabitHandle h = reader_.get().handleOf(o.habit);
+        if (h == kNoHabit) return fail(cmd, "unknown habit " + o.habit);
+        int changed = manager_.setCompletedRange(h, from, to, done);
+        emit({{"cmd", cmd}, {"ok", true}, {"habit", o.habit}, {"from", date::toISO(from)},
+              {"to", date::toISO(to)}, {"changed", changed}});
+    }
+
+    void list() {
+        date::Day today = date::today();
+        json habits = json::array();
+        for (const auto& h : reader_.get())
+            habits.push_back({{"name", std::string(h.getName())}, {"streak", h.currentStreak(today)},
+                              {"longest", h.longestStreak()}, {"today", h.isCompletedOn(today)}});
+        emit({{"cmd", "list"}, {"ok", true}, {"habits", std::move(habits)}});
+    }
+
+    void report(const Options& o) {
+        date::Day today = date::today(), from, to;
+        if (!parseDay(o.to, today, to)) return fail("report", "bad date " + o.to);
+        if (!parseDay(o.from, to - 6, from)) return fail("report", "bad date " + o.from);
+        if (from > to) return fail("report", "--from is after --to");
+
+        const HabitSnapshot& snapshot = reader_.get();
+        std::vector<HabitStats> stats;
+        if (o.habit.empty()) {
+            stats = HabitManager::stats(snapshot, from, to);
+        } else {
+            const Habit* h = snapshot.find(o.habit);
+            if (!h) return fail("report", "unknown habit " + o.habit);
+            stats.push_back(habitStats(*h, from, to));
+        }
+
+        json habits = json::array();
+        for (const auto& st : stats)
+            habits.push_back({{"name", std::string(st.name)}, {"completed", st.completed},
+                              {"days", st.days}, {"rate", st.rate}, {"streak", st.currentStreak},
+                              {"longest", st.longestStreak}});
+        emit({{"cmd", "report"}, {"ok", true}, {"from", date::toISO(from)}, {"to", date::toISO(to)},
+              {"habits", std::move(habits)}});
+    }
+};
+
+} // namespace
+
+bool isCommand(const char* arg) {
+    for (const char* c : kCommands)
+        if (std::strcmp(arg, c) == 0) return true;
+    return false;
+}
+
+int run(const std::vector<std::string>& args, std::istream& in, std::ostream& out) {
+    std::ostream sink(out.rdbuf());          // out may be std::cout, silenced below
+    Options top;
+    std::string error;
+    if (args.empty() || !isCommand(args[0].c_str())) {
+        sink << json{{"cmd", args.empty() ? "" : args[0]}, {"ok", false}, {"error", "unknown command"}}.dump() << '\n';
+        return 2;
+    }
+    if (!parseOptions(args, true, top, error)) {
+        sink << json{{"cmd", args[0]}, {"ok", false}, {"error", error}}.dump() << '\n';
+        return 2;
+    }
+
+    if (top.db.empty()) top.db = top.backend == Backend::Log ? "habits.log" : "habits.db";
+
+    NullBuf nullBuf;
+    std::streambuf* coutBuf = std::cout.rdbuf(&nullBuf);
+    int code;
+    {
+        HabitManager manager;
+        Session session(manager, sink);
+        if (!manager.openDB(top.db, top.backend) || !manager.loadFromDB()) {
+            session.fail(args[0], "cannot open " + top.db);
+        } else {
+            // every command shares one transaction, committed at the end
+            manager.beginBatch(std::numeric_limits<std::size_t>::max(), std::chrono::hours(24));
+            if (args[0] == "batch") session.batch(in);
+            else session.exec(args[0], top);
+            manager.endBatch();
+        }
+        code = session.failed() ? 1 : 0;
+    }
+    std::cout.rdbuf(coutBuf);
+    return code;
+}
+
+} // namespace cli
@@ -0,0 +1,179 @@
+#include "CompletionBitmap.h"
+
+using date::Day;
+
+bool CompletionBitmap::test(Day d) const {
+    if (d < base_) return false;
+    std::size_t off = static_cast<std::size_t>(d - base_);
+    if (off / 64 >= words_.size()) return false;
+    return (words_[off / 64] >> (off % 64)) & 1u;
+}
+
+void CompletionBitmap::cover(Day from, Day to) {
+    if (words_.empty()) {
+        base_ = wordBase(from);
+        words_.assign(1, 0);
+    } else if (from < base_) {
+        // grow towards the past: prepend whole words
+        Day newBase = wordBase(from);
+        words_.insert(words_.begin(), static_cast<std::size_t>((base_ - newBase) / 64), 0);
+        base_ = newBase;
+    }
+    std::size_t off = static_cast<std::size_t>(to - base_);
+    if (off / 64 >= words_.size()) words_.resize(off / 64 + 1, 0);
+}
+
+bool CompletionBitmap::set(Day d) {
+    cover(d, d);
+    std::size_t off = static_cast<std::size_t>(d - base_);
+    std::uint64_t mask = std::uint64_t{1} << (off % 64);
+    if (words_[off / 64] & mask) return false;
+    words_[off / 64] |= mask;
+    ++count_;
+    return true;
+}
+
+bool CompletionBitmap::reset(Day d) {
+    if (!test(d)) return false;
+    std::size_t off = static_cast<std::size_t>(d - base_);
+    words_[off / 64] &= ~(std::uint64_t{1} << (off % 64));
+    if (--count_ == 0) words_.clear();
+    return true;
+}
+
+int CompletionBitmap::setRange(Day from, Day to, std::vector<Day>* changedDays) {
+    if (to < from) return 0;
+    cover(from, to);
+    int changed = 0;
+    std::size_t last = static_cast<std::size_t>(to - base_) / 64;
+    for (std::size_t w = static_cast<std::size_t>(from - base_) / 64; w <= last; ++w) {
+        std::uint64_t flips = rangeMask(w, from, to) & ~words_[w];
+        changed += __builtin_popcountll(flips);
+        appendDays(w, flips, changedDays);
+        words_[w] |= flips;
+    }
+    count_ += static_cast<std::size_t>(changed);
+    return changed;
+}
+
+int CompletionBitmap::resetRange(Day from, Day to, std::vector<Day>* changedDays) {
+    if (words_.empty() || to < from) return 0;
+    if (from < base_) from = base_;
+    Day end = base_ + static_cast<Day>(words_.size() * 64) - 1;
+    if (to > end) to = end;
+    if (to < from) return 0;
+    int changed = 0;
+    std::size_t last = static_cast<std::size_t>(to - base_) / 64;
+    for (std::size_t w = static_cast<std::size_t>(from - base_) / 64; w <= last; ++w) {
+        std::uint64_t flips = rangeMask(w, from, to) & words_[w];
+        changed += __builtin_popcountll(flips);
+        appendDays(w, flips, changedDays);
+        words_[w] &= ~flips;
+    }
+    count_ -= static_cast<std::size_t>(changed);
+    if (count_ == 0) words_.clear();
+    return changed;
+}
+
+int CompletionBitmap::setWords(Day base, const std::uint64_t* words, std::size_t n) {
+    if (n == 0) return 0;
+    cover(base, base + static_cast<Day>(n * 64) - 1);
+    std::size_t first = static_cast<std::size_t>(base - base_) / 64;
+    int changed = 0;
+    for (std::size_t k = 0; k < n; ++k) {
+        changed += __builtin_popcountll(words[k] & ~words_[first + k]);
+        words_[first + k] |= words[k];
+    }
+    count_ += static_cast<std::size_t>(changed);
+    if (count_ == 0) words_.clear();
+    return changed;
+}
+
+Day CompletionBitmap::first() const {
+    std::size_t w = 0;
+    while (words_[w] == 0) ++w;
+    return base_ + static_cast<Day>(w * 64) + __builtin_ctzll(words_[w]);
+}
+
+Day CompletionBitmap::last() const {
+    std::size_t w = words_.size() - 1;
+    while (words_[w] == 0) --w;
+    return base_ + static_cast<Day>(w * 64) + 63 - __builtin_clzll(words_[w]);
+}
+
+// Runs are scanned a word at a time: count the ones adjacent to d inside its
+// word, then skip over all-ones words.
+Day CompletionBitmap::runStart(Day d) const {
+    std::size_t off = static_cast<std::size_t>(d - base_);
+    std::size_t w = off / 64;
+    unsigned b = off % 64;
+    std::uint64_t up = ~(words_[w] << (63 - b));          // zeros mark the run
+    unsigned ones = up ? static_cast<unsigned>(__builtin_clzll(up)) : 64;
+    if (ones <= b) return d - static_cast<Day>(ones) + 1;
+    while (w > 0 && words_[w - 1] == ~std::uint64_t{0}) --w;
+    if (w == 0) return base_;
+    std::uint64_t prev = ~words_[w - 1];
+    return base_ + static_cast<Day>(w * 64) - __builtin_clzll(prev);
+}
+
+Day CompletionBitmap::runEnd(Day d) const {
+    std::size_t off = static_cast<std::size_t>(d - base_);
+    std::size_t w = off / 64;
+    unsigned b = off % 64;
+    std::uint64_t down = ~(words_[w] >> b);               // zeros mark the run
+    unsigned ones = down ? static_cast<unsigned>(__builtin_ctzll(down)) : 64;
+    if (ones < 64 - b) return d + static_cast<Day>(ones) - 1;
+    ++w;
+    while (w < words_.size() && words_[w] == ~std::uint64_t{0}) ++w;
+    if (w == words_.size()) return base_ + static_cast<Day>(w * 64) - 1;
+    return base_ + static_cast<Day>(w * 64) + __builtin_ctzll(~words_[w]) - 1;
+}
+
+int CompletionBitmap::longestRun() const {
+    int best = 0, run = 0;
+    for (std::uint64_t word : words_) {
+        if (word == ~std::uint64_t{0}) { run += 64; continue; }
+        for (int b = 0; b < 64; ++b) {
+            if ((word >> b) & 1u) { ++run; continue; }
+            if (run > best) best = run;
+            run = 0;
+        }
+    }
+    return run > best ? run : best;
+}
+
+int CompletionBitmap::longestRun(Day from, Day to) const {
+    if (words_.empty()) return 0;
+    if (from < base_) from = base_;
+    Day end = base_ + static_cast<Day>(words_.size() * 64) - 1;
+    if (to > end) to = end;
+    int best = 0, run = 0;
+    for (Day d = from; d <= to;) {
+        std::size_t off = static_cast<std::size_t>(d - base_);
+        std::uint64_t word = words_[off / 64] >> (off % 64);
+        int n = static_cast<int>(64 - off % 64);
+        if (to - d + 1 < n) n = to - d + 1;
+        if (n == 64 && word == ~std::uint64_t{0}) { run += 64; d += 64; continue; }
+        for (int b = 0; b < n; ++b) {
+            if ((word >> b) & 1u) { ++run; continue; }
+            if (run > best) best = run;
+            run = 0;
+        }
+        d += n;
+    }
+    return run > best ? run : best;
+}
+
+int CompletionBitmap::count(Day from, Day to) const {
+    int n = 0;
+    forEachWord(from, to, [&](std::uint64_t bits, Day) { n += __builtin_popcountll(bits); });
+    return n;
+}
+
+std::uint64_t CompletionBitmap::window(Day from, int n) const {
+    std::uint64_t out = 0;
+    forEachWord(from, from + n - 1, [&](std::uint64_t bits, Day shift) {
+        out |= shift >= 0 ? bits << shift : bits >> -shift;
+    });
+    return out;
+}
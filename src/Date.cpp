@@ -0,0 +1,74 @@
+#include "Date.h"
+#include <atomic>
+#include <ctime>
+
+namespace date {
+
+std::string toISO(Day d) {
+    Civil c = toCivil(d);
+    char buf[11];
+    unsigned y = static_cast<unsigned>(c.year);
+    buf[0] = static_cast<char>('0' + (y / 1000) % 10);
+    buf[1] = static_cast<char>('0' + (y / 100) % 10);
+    buf[2] = static_cast<char>('0' + (y / 10) % 10);
+    buf[3] = static_cast<char>('0' + y % 10);
+    buf[4] = '-';
+    buf[5] = static_cast<char>('0' + c.month / 10);
+    buf[6] = static_cast<char>('0' + c.month % 10);
+    buf[7] = '-';
+    buf[8] = static_cast<char>('0' + c.day / 10);
+    buf[9] = static_cast<char>('0' + c.day % 10);
+    buf[10] = '\0';
+    return std::string(buf, 10);
+}
+
+bool parseISO(const std::string& s, Day& out) {
+    return parseISO(s.data(), s.size(), out);
+}
+
+bool parseISO(const char* s, std::size_t n, Day& out) {
+    if (n != 10 || s[4] != '-' || s[7] != '-') return false;
+    auto digits = [&](int from, int n, unsigned& v) {
+        v = 0;
+        for (int i = from; i < from + n; ++i) {
+            if (s[i] < '0' || s[i] > '9') return false;
+            v = v * 10 + static_cast<unsigned>(s[i] - '0');
+        }
+        return true;
+    };
+    unsigned y, m, d;
+    if (!digits(0, 4, y) || !digits(5, 2, m) || !digits(8, 2, d)) return false;
+    if (m < 1 || m > 12 || d < 1 || d > 31) return false;
+    Day day = fromCivil(static_cast<int>(y), m, d);
+    if (toCivil(day).day != d) return false;      // e.g. 2025-02-30
+    out = day;
+    return true;
+}
+
+// The local day only changes at midnight, so the conversion (localtime_r,
+// which takes the tz lock) runs once per day; other calls compare time(nullptr)
+// against the cached rollover instant.
+namespace {
+std::atomic<std::time_t> nextRollover{0};
+std::atomic<Day> cachedToday{0};
+}
+
+Day today() {
+    std::time_t now = std::time(nullptr);
+    if (now < nextRollover.load(std::memory_order_acquire))
+        return cachedToday.load(std::memory_order_relaxed);
+
+    std::tm tm{};
+    localtime_r(&now, &tm);
+    Day d = fromCivil(tm.tm_year + 1900, static_cast<unsigned>(tm.tm_mon + 1),
+                      static_cast<unsigned>(tm.tm_mday));
+    std::tm midnight = tm;
+    midnight.tm_mday += 1;
+    midnight.tm_hour = midnight.tm_min = midnight.tm_sec = 0;
+    midnight.tm_isdst = -1;
+    cachedToday.store(d, std::memory_order_relaxed);
+    nextRollover.store(std::mktime(&midnight), std::memory_order_release);
+    return d;
+}
+
+} // namespace date
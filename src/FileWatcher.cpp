@@ -0,0 +1,63 @@
+#include "FileWatcher.h"
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+FileWatcher::FileWatcher(const std::string& path) {
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    std::string::size_type slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    name_ = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) return;
+    if (inotify_add_watch(fd_, dir.c_str(), IN_MODIFY | IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE) < 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    if (fd_ >= 0) ::close(fd_);
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+}
+
+void FileWatcher::wake() {
+    std::uint64_t one = 1;
+    if (wakeFd_ >= 0) (void)!::write(wakeFd_, &one, sizeof one);
+}
+
+// Events for other files in the directory are read and dropped without
+// ending the wait.
+bool FileWatcher::wait(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (left.count() < 0) return false;
+
+        pollfd fds[2] = {{wakeFd_, POLLIN, 0}, {fd_, POLLIN, 0}};
+        if (poll(fds, fd_ >= 0 ? 2 : 1, static_cast<int>(left.count())) <= 0) return false;
+        if (fds[0].revents & POLLIN) {
+            std::uint64_t n;
+            (void)!::read(wakeFd_, &n, sizeof n);
+            return false;
+        }
+
+        bool hit = false;
+        alignas(inotify_event) char buf[4096];
+        ssize_t len;
+        while ((len = ::read(fd_, buf, sizeof buf)) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                auto* e = reinterpret_cast<inotify_event*>(p);
+                if (e->len && std::strncmp(e->name, name_.c_str(), name_.size()) == 0) hit = true;
+                p += sizeof(inotify_event) + e->len;
+            }
+        }
+        if (hit) return true;
+    }
+}
@@ -1,56 +1,177 @@
 #include "Habit.h"
+#include "Metrics.h"
+#include "Pool.h"
+#include <algorithm>
 #include <nlohmann/json.hpp>
-#include <chrono>
-#include <ctime>
-#include <iomanip>
-#include <sstream>
-#include <sqlite3.h>
 
 using nlohmann::json;
 
-Habit::Habit(const std::string& habitName) : name_(habitName) {}
+Habit::Habit(std::string_view habitName) : name_(pool::intern(habitName)) {}
 
-void Habit::markCompleteToday() { completedDates_.insert(todayISO()); }
-void Habit::unmarkToday()       { completedDates_.erase(todayISO()); }
+void Habit::markCompleteToday() { setCompletedOn(date::today(), true); }
+void Habit::unmarkToday()       { setCompletedOn(date::today(), false); }
 
-bool Habit::isCompletedOn(const std::string& date) const {
-    return completedDates_.count(date) > 0;
+void Habit::setCompletedOn(date::Day day, bool done) {
+    if (done) { if (!completed_.set(day))   return; onSet(day); }
+    else      { if (!completed_.reset(day)) return; onReset(day); }
+    ++revision_;
 }
 
-int Habit::currentStreak() const {
-    // Walk backward from today; stop at the first missing day.
-    int streak = 0;
-    auto day = std::chrono::system_clock::now();
-    while (true) {
-        std::time_t tt = std::chrono::system_clock::to_time_t(day);
-        std::tm tm = *std::localtime(&tt);
-        char buf[11];
-        std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
-        if (isCompletedOn(buf)) {
-            ++streak;
-            day -= std::chrono::hours(24);
-        } else break;
+int Habit::setCompletedRange(date::Day from, date::Day to, bool done, std::vector<date::Day>* days) {
+    if (to < from || static_cast<std::int64_t>(to) - from >= kMaxRangeDays) return 0;
+    int changed;
+    if (done) {
+        bool wasEmpty = completed_.empty();
+        changed = completed_.setRange(from, to, days);
+        if (changed) onSetRange(from, to, wasEmpty);
+    } else {
+        if (completed_.empty()) return 0;
+        // the runs the range cuts, measured before they are cut
+        date::Day s = completed_.test(from) ? completed_.runStart(from) : from;
+        date::Day e = completed_.test(to) ? completed_.runEnd(to) : to;
+        bool wasLongest = completed_.longestRun(s, e) == longest_;
+        changed = completed_.resetRange(from, to, days);
+        if (changed) onResetRange(from, to, wasLongest);
     }
-    return streak;
+    if (changed) ++revision_;
+    return changed;
 }
 
-std::string Habit::getName() const { return name_; }
+int Habit::setCompletedDays(std::vector<date::Day> days, bool done) {
+    std::sort(days.begin(), days.end());
+    int changed = 0;
+    for (std::size_t i = 0; i < days.size();) {
+        // one range per stretch of consecutive (or repeated) days
+        std::size_t j = i + 1;
+        while (j < days.size() && days[j] - days[j - 1] <= 1) ++j;
+        changed += setCompletedRange(days[i], days[j - 1], done);
+        i = j;
+    }
+    return changed;
+}
+
+int Habit::setCompletedWords(date::Day base, const std::uint64_t* words, std::size_t n) {
+    int changed = completed_.setWords(base, words, n);
+    if (!changed) return 0;
+    runEnd_ = completed_.last();
+    runStart_ = completed_.runStart(runEnd_);
+    longest_ = completed_.longestRun();
+    ++revision_;
+    return changed;
+}
+
+// Streak bookkeeping. Appending to the latest run is O(1); anything else
+// rescans only the run around `day`, and the longest streak is rebuilt only
+// when the run being shortened was the longest one.
+void Habit::onSet(date::Day day) {
+    if (completed_.count() == 1) {
+        runStart_ = runEnd_ = day;
+        longest_ = 1;
+        return;
+    }
+    if (day == runEnd_ + 1) {
+        runEnd_ = day;
+        if (runEnd_ - runStart_ + 1 > longest_) longest_ = runEnd_ - runStart_ + 1;
+        return;
+    }
+    date::Day s = completed_.runStart(day);
+    date::Day e = completed_.runEnd(day);
+    if (e - s + 1 > longest_) longest_ = e - s + 1;
+    if (e >= runEnd_) { runStart_ = s; runEnd_ = e; }
+}
+
+void Habit::onReset(date::Day day) {
+    if (completed_.empty()) {
+        runStart_ = runEnd_ = 0;
+        longest_ = 0;
+        return;
+    }
+    date::Day s = completed_.test(day - 1) ? completed_.runStart(day - 1) : day;
+    date::Day e = completed_.test(day + 1) ? completed_.runEnd(day + 1) : day;
+    bool wasLongest = e - s + 1 == longest_;
+
+    if (day >= runStart_ && day <= runEnd_) {
+        if (day < runEnd_) {
+            runStart_ = day + 1;
+        } else {
+            runEnd_ = completed_.last();
+            runStart_ = completed_.runStart(runEnd_);
+        }
+    }
+    if (wasLongest) {
+        HABIT_TIMER(kStreakRescan);
+        longest_ = completed_.longestRun();
+    }
+}
+
+// Range versions: only the runs at the ends of the range are rescanned.
+void Habit::onSetRange(date::Day from, date::Day to, bool wasEmpty) {
+    date::Day s = completed_.runStart(from);
+    date::Day e = completed_.runEnd(to);
+    if (wasEmpty) {
+        runStart_ = s;
+        runEnd_ = e;
+        longest_ = e - s + 1;
+        return;
+    }
+    if (e - s + 1 > longest_) longest_ = e - s + 1;
+    if (e >= runEnd_) { runStart_ = s; runEnd_ = e; }
+}
+
+void Habit::onResetRange(date::Day from, date::Day to, bool wasLongest) {
+    if (completed_.empty()) {
+        runStart_ = runEnd_ = 0;
+        longest_ = 0;
+        return;
+    }
+    if (to >= runStart_ && from <= runEnd_) {
+        if (to < runEnd_) {
+            runStart_ = to + 1;
+        } else {
+            runEnd_ = completed_.last();
+            runStart_ = completed_.runStart(runEnd_);
+        }
+    }
+    if (wasLongest) {
+        HABIT_TIMER(kStreakRescan);
+        longest_ = completed_.longestRun();
+    }
+}
+
+bool Habit::isCompletedOn(const std::string& iso) const {
+    date::Day day;
+    return date::parseISO(iso, day) && completed_.test(day);
+}
+
+int Habit::currentStreak() const { return currentStreak(date::today()); }
+
+int Habit::currentStreak(date::Day today) const {
+    HABIT_COUNT(kStreakQuery);
+    // Only the run that contains today counts (days after today are ignored).
+    if (completed_.empty()) return 0;
+    if (today >= runStart_ && today <= runEnd_) return today - runStart_ + 1;
+    return completed_.test(today) ? today - completed_.runStart(today) + 1 : 0;
+}
 
 json Habit::toJson() const {
-    return json{{"name", name_}, {"dates", completedDates_}};
+    std::vector<std::string> dates;
+    dates.reserve(completed_.count());
+    completed_.forEach([&](date::Day d) { dates.push_back(date::toISO(d)); });
+    return json{{"name", std::string(name_)}, {"dates", dates}};
 }
 
 Habit Habit::fromJson(const json& j) {
     Habit h(j.at("name").get<std::string>());
-    h.completedDates_ = j.value("dates", std::set<std::string>{});
+    auto it = j.find("dates");
+    if (it != j.end()) {
+        for (const auto& d : *it) {
+            date::Day day;
+            if (date::parseISO(d.get<std::string>(), day)) h.setCompletedOn(day, true);
+        }
+    }
     return h;
 }
 
 std::string Habit::todayISO() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t tt = std::chrono::system_clock::to_time_t(now);
-    std::tm tm = *std::localtime(&tt);
-    char buf[11];
-    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
-    return std::string(buf);
+    return date::toISO(date::today());
 }
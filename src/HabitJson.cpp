@@ -0,0 +1,127 @@
+#include "HabitJson.h"
+#include <nlohmann/json.hpp>
+#include <ostream>
+#include <vector>
+
+using nlohmann::json;
+
+// ----------------- Writer -----------------
+// Output matches json::dump(2) (or dump() when compact) of Habit::toJson(),
+// so files written either way are byte-identical.
+
+HabitJsonWriter::HabitJsonWriter(std::ostream& out, bool compact)
+    : out_(out), compact_(compact) {
+    out_ << '[';
+}
+
+void HabitJsonWriter::write(const Habit& h) {
+    const char* nl   = compact_ ? "" : "\n";
+    const char* ind1 = compact_ ? "" : "  ";
+    const char* ind2 = compact_ ? "" : "    ";
+    const char* ind3 = compact_ ? "" : "      ";
+    const char* colon = compact_ ? ":" : ": ";
+
+    out_ << (first_ ? "" : ",") << nl << ind1 << '{' << nl;
+    first_ = false;
+
+    out_ << ind2 << "\"dates\"" << colon << '[';
+    bool firstDay = true;
+    h.completions().forEach([&](date::Day d) {
+        out_ << (firstDay ? "" : ",") << nl << ind3 << '"' << date::toISO(d) << '"';
+        firstDay = false;
+    });
+    if (!firstDay) out_ << nl << ind2;
+    out_ << "]," << nl;
+
+    out_ << ind2 << "\"name\"" << colon << json(h.getName()).dump() << nl << ind1 << '}';
+}
+
+void HabitJsonWriter::finish() {
+    if (!first_ && !compact_) out_ << '\n';
+    out_ << ']';
+}
+
+// ----------------- Reader -----------------
+
+namespace {
+
+// Depth 1 is the top-level array, 2 a habit object, 3 a value inside it.
+// Keys other than "name" and "dates" are skipped along with their values.
+class HabitSaxReader : public nlohmann::json_sax<json> {
+public:
+    explicit HabitSaxReader(const std::function<void(Habit&&)>& onHabit) : onHabit_(onHabit) {}
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t) override { return true; }
+    bool number_unsigned(number_unsigned_t) override { return true; }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& val) override {
+        if (depth_ == 2 && field_ == Field::Name) {
+            name_ = std::move(val);
+            hasName_ = true;
+        } else if (depth_ == 3 && field_ == Field::Dates) {
+            date::Day day;
+            if (date::parseISO(val, day)) days_.push_back(day);
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (depth_ == 0) return false;            // top level must be an array
+        if (++depth_ == 2) {
+            name_.clear();
+            days_.clear();
+            hasName_ = false;
+            field_ = Field::Other;
+        }
+        return true;
+    }
+
+    bool key(string_t& k) override {
+        if (depth_ == 2)
+            field_ = k == "name" ? Field::Name : k == "dates" ? Field::Dates : Field::Other;
+        return true;
+    }
+
+    bool end_object() override {
+        if (depth_ == 2 && hasName_) {
+            Habit h(name_);
+            for (date::Day d : days_) h.setCompletedOn(d, true);
+            onHabit_(std::move(h));
+        }
+        --depth_;
+        return true;
+    }
+
+    bool start_array(std::size_t) override { ++depth_; return true; }
+    bool end_array() override { --depth_; return true; }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+        return false;
+    }
+
+private:
+    enum class Field { Name, Dates, Other };
+
+    const std::function<void(Habit&&)>& onHabit_;
+    int depth_ = 0;
+    Field field_ = Field::Other;
+    std::string name_;
+    bool hasName_ = false;
+    std::vector<date::Day> days_;         // "dates" precedes "name" in exports
+};
+
+} // namespace
+
+bool readHabitJson(std::istream& in, const std::function<void(Habit&&)>& onHabit) {
+    HabitSaxReader reader(onHabit);
+    return json::sax_parse(in, &reader);
+}
+
+bool readHabitJson(const char* first, const char* last, const std::function<void(Habit&&)>& onHabit) {
+    HabitSaxReader reader(onHabit);
+    return json::sax_parse(first, last, &reader);
+}
@@ -1,196 +1,522 @@
 #include "HabitManager.h"
+#include "HabitJson.h"
+#include "Metrics.h"
+#include "Pool.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
-#include <chrono>
-#include <ctime>
-#include <nlohmann/json.hpp>
-#include <sqlite3.h>
-
-using nlohmann::json;
+#include <limits>
 
 // ----------------- Constructor / Destructor -----------------
 
-HabitManager::HabitManager() = default;
+// versions, chunks and habits are allocated (with their control blocks) from
+// the habit pool
+template <typename T, typename... Args>
+static std::shared_ptr<T> makePooled(Args&&... args) {
+    return std::allocate_shared<T>(pool::Allocator<T>(), std::forward<Args>(args)...);
+}
+
+HabitManager::HabitManager() : current_(makePooled<Version>()) {
+    std::const_pointer_cast<Version>(current_)->index = makePooled<HabitSnapshot::Index>();
+}
 
 HabitManager::~HabitManager() {
-    if (db_) {
-        sqlite3_close(db_);
-        db_ = nullptr;
+    stopWatching();
+    stopBatchTimer();
+    stopAsyncWriter();
+    if (storage_) flush();
+}
+
+bool HabitManager::openDB(const std::string& path, Backend backend) {
+    stopWatching();                        // before the lock: the watch thread takes it
+    std::lock_guard<std::recursive_mutex> lock(writeMu_);
+    auto storage = backend == Backend::Log ? makeLogStorage() : makeSqliteStorage();
+    if (!storage->open(path)) return false;
+    stopAsyncWriter();
+    if (storage_) flush();
+    storage_ = std::move(storage);
+    return true;
+}
+
+// ----------------- Write batching -----------------
+
+void HabitManager::beginBatch(std::size_t maxOps, std::chrono::milliseconds maxDelay) {
+    std::lock_guard<std::recursive_mutex> lock(writeMu_);
+    batching_ = true;
+    batchMaxOps_ = maxOps;
+    batchMaxDelay_ = maxDelay;
+    if (!batchTimer_.joinable()) {
+        timerRunning_ = true;
+        batchTimer_ = std::thread([this] { batchTimerLoop(); });
+    }
+    // open the transaction now, so habits added before the first completion
+    // are part of it
+    if (storage_ && !writer_ && !inTxn_) startTxn();
+}
+
+// batching_ is cleared before the flush, under the same lock, so no write
+// can open a transaction after it that the stopped timer would never commit
+void HabitManager::endBatch() {
+    {
+        std::lock_guard<std::recursive_mutex> lock(writeMu_);
+        batching_ = false;
+        flush();
+    }
+    stopBatchTimer();
+}
+
+void HabitManager::startTxn() {
+    storage_->begin();
+    inTxn_ = true;
+    batchStart_ = std::chrono::steady_clock::now();
+    armBatchTimer();
+}
+
+// under writeMu_: points the timer at the open transaction's deadline
+void HabitManager::armBatchTimer() {
+    std::lock_guard<std::mutex> lock(timerMu_);
+    batchDeadline_ = inTxn_ ? batchStart_ + batchMaxDelay_ : std::chrono::steady_clock::time_point::max();
+    timerCv_.notify_one();
+}
+
+// Sleeps until the deadline, then commits under writeMu_ (taking it only
+// with timerMu_ released) and re-arms for whatever is open by then.
+void HabitManager::batchTimerLoop() {
+    std::unique_lock<std::mutex> lock(timerMu_);
+    while (timerRunning_) {
+        if (batchDeadline_ == std::chrono::steady_clock::time_point::max()) { timerCv_.wait(lock); continue; }
+        if (timerCv_.wait_until(lock, batchDeadline_) == std::cv_status::no_timeout) continue;
+        lock.unlock();
+        {
+            std::lock_guard<std::recursive_mutex> write(writeMu_);
+            flushIfDue();
+            armBatchTimer();
+        }
+        lock.lock();
     }
 }
 
-// open or create the database and ensure tables exist
-bool HabitManager::openDB(const std::string& path) {
-    if (sqlite3_open(path.c_str(), &db_) != SQLITE_OK) {
-        std::cerr << "Cannot open DB: " << sqlite3_errmsg(db_) << "\n";
-        db_ = nullptr;
-        return false;
+// must not be called under writeMu_: the timer may be waiting for it
+void HabitManager::stopBatchTimer() {
+    {
+        std::lock_guard<std::recursive_mutex> write(writeMu_);
+        batching_ = false;
+    }
+    if (!batchTimer_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(timerMu_);
+        timerRunning_ = false;
+        timerCv_.notify_one();
     }
-    const char* habits_sql =
-        "CREATE TABLE IF NOT EXISTS habits("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "name TEXT UNIQUE);";
-    sqlite3_exec(db_, habits_sql, nullptr, nullptr, nullptr);
+    batchTimer_.join();
+}
+
+void HabitManager::flush() {
+    std::lock_guard<std::recursive_mutex> lock(writeMu_);
+    if (writer_) writer_->drain();
+    if (!inTxn_) return;
+    storage_->commit();
+    inTxn_ = false;
+    pending_ = 0;
+}
+
+bool HabitManager::flushIfDue() {
+    std::lock_guard<std::recursive_mutex> lock(writeMu_);
+    if (!inTxn_ || std::chrono::steady_clock::now() - batchStart_ < batchMaxDelay_) return false;
+    flush();
+    return true;
+}
 
-    const char* completions_sql =
-        "CREATE TABLE IF NOT EXISTS completions("
-        "habit_id INTEGER,"
-        "date TEXT,"
-        "PRIMARY KEY(habit_id,date));";
-    sqlite3_exec(db_, completions_sql, nullptr, nullptr, nullptr);
+// Outside a batch every write is applied on its own; inside one, writes share
+// a transaction until a limit is hit.
+void HabitManager::writeCompletion(int habit_id, date::Day day, bool done) {
+    if (!storage_ || habit_id == -1) return;
+    if (writer_) { writer_->push(habit_id, day, done); return; }
+    if (batching_ && !inTxn_) startTxn();
+    storage_->setCompletion(habit_id, day, done);
+    if (inTxn_ && (++pending_ >= batchMaxOps_ ||
+                   std::chrono::steady_clock::now() - batchStart_ >= batchMaxDelay_))
+        flush();
+}
+
+// Several days of one habit: a transaction of their own outside a batch,
+// otherwise they count against the batch limits like single writes.
+void HabitManager::writeCompletions(int habit_id, const std::vector<date::Day>& days, bool done) {
+    if (!storage_ || habit_id == -1 || days.empty()) return;
+    if (writer_) {
+        for (date::Day d : days) writer_->push(habit_id, d, done);
+        return;
+    }
+    bool own = !batching_;
+    if (!inTxn_) startTxn();
+    for (date::Day d : days) storage_->setCompletion(habit_id, d, done);
+    pending_ += days.size();
+    if (own || pending_ >= batchMaxOps_ ||
+        std::chrono::steady_clock::now() - batchStart_ >= batchMaxDelay_)
+        flush();
+}
 
+// ----------------- Async writer -----------------
+
+bool HabitManager::startAsyncWriter() {
+    std::lock_guard<std::recursive_mutex> lock(writeMu_);
+    if (!storage_) return false;
+    if (writer_) return true;
+    flush();                               // nothing pending on this connection
+    std::unique_ptr<Storage> handle = storage_->openWriter();
+    if (!handle) return false;
+    auto writer = std::make_unique<AsyncWriter>();
+    if (!writer->start(std::move(handle))) return false;
+    writer_ = std::move(writer);
     return true;
 }
 
+void HabitManager::stopAsyncWriter() {
+    std::lock_guard<std::recursive_mutex> lock(writeMu_);
+    if (!writer_) return;
+    writer_->stop();
+    writer_.reset();
+}
+
+AsyncWriter::Stats HabitManager::asyncWriterStats() const {
+    std::lock_guard<std::recursive_mutex> lock(writeMu_);
+    if (!writer_) return AsyncWriter::Stats{0, 0, 0, 0, 0, 0, 0};
+    return writer_->stats();
+}
+
+// ----------------- Versions -----------------
+
+HabitSnapshot HabitManager::getHabits() const {
+    std::lock_guard<std::mutex> lock(publishMu_);
+    return HabitSnapshot(current_);
+}
+
+const HabitSnapshot& HabitManager::Reader::get() {
+    std::uint64_t v = manager_.published_.load(std::memory_order_acquire);
+    if (v != seen_) {
+        snapshot_ = manager_.getHabits();
+        seen_ = v;
+    }
+    return snapshot_;
+}
+
+// The draft starts as a copy of the chunk table; chunks, habits and the index
+// stay shared with current_ until editHabit()/adoptSlot() needs to change them.
+HabitManager::Version& HabitManager::edit() {
+    if (!draft_) draft_ = makePooled<Version>(*current_);
+    return *draft_;
+}
+
+// A chunk or habit only the draft points to is edited in place. Anything else
+// may be visible to a reader and is copied first (nothing but the writer can
+// add a reference to a draft-only object, so the count check is not racy).
+// A count of 1 may come from a reader that just dropped its snapshot, outside
+// any lock; use_count() is a relaxed load, so the acquire fence pairs with
+// that release decrement and the reader's last reads happen before our writes.
+template <typename T>
+static T& unshare(std::shared_ptr<T>& p) {
+    if (p.use_count() > 1) p = makePooled<T>(*p);
+    else std::atomic_thread_fence(std::memory_order_acquire);
+    return *p;
+}
+
+Habit& HabitManager::editHabit(std::size_t slot) {
+    HabitSnapshot::Chunk& chunk = unshare(edit().chunks[slot / HabitSnapshot::kChunk]);
+    return unshare(chunk[slot % HabitSnapshot::kChunk]);
+}
+
+const Habit& HabitManager::habitAt(std::size_t slot) const {
+    return *(*latest().chunks[slot / HabitSnapshot::kChunk])[slot % HabitSnapshot::kChunk];
+}
+
+void HabitManager::publish() {
+    if (!draft_) return;
+    {
+        std::lock_guard<std::mutex> lock(publishMu_);
+        current_ = std::move(draft_);
+    }
+    draft_.reset();
+    published_.fetch_add(1, std::memory_order_release);
+}
+
 // ----------------- Add / Find -----------------
 
-void HabitManager::addHabit(const std::string& name) {
-    if (find(name)) {
+void HabitManager::addHabit(std::string_view name) {
+    WriteLock lock(*this);
+    if (slotOf(name) != npos) {
         std::cout << "Habit already exists.\n";
         return;
     }
-    habits_.emplace_back(name);
-
     // also insert into DB if available
-    if (db_) {
-        sqlite3_stmt* stmt;
-        const char* sql = "INSERT OR IGNORE INTO habits(name) VALUES(?);";
-        if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-            sqlite3_step(stmt);
-            sqlite3_finalize(stmt);
-        }
-    }
+    addSlot(name, insertHabitRow(name));
 
     std::cout << "Added: " << name << "\n";
 }
 
-const std::vector<Habit>& HabitManager::getHabits() const {
-    return habits_;
+bool HabitManager::addHabit(Habit habit) {
+    std::vector<Habit> one;
+    one.push_back(std::move(habit));
+    return addHabits(std::move(one)) == 1;
+}
+
+std::size_t HabitManager::addHabits(std::vector<Habit> habits) {
+    WriteLock lock(*this);
+    reserveIndex(latest().index->size + habits.size());
+    // outside a batch, all of it is one unbounded batch of its own (settings
+    // swapped as in importFile); inside one, the batch's limits apply
+    bool own = storage_ && !writer_ && !batching_;
+    std::size_t oldMaxOps = batchMaxOps_;
+    std::chrono::milliseconds oldMaxDelay = batchMaxDelay_;
+    if (own) {
+        batching_ = true;
+        batchMaxOps_ = std::numeric_limits<std::size_t>::max();
+        batchMaxDelay_ = std::chrono::hours(24);
+    }
+    std::size_t added = 0;
+    for (Habit& habit : habits) {
+        if (slotOf(habit.getName()) != npos) continue;
+        if (storage_ && !writer_ && batching_ && !inTxn_) startTxn();   // the row joins the batch
+        int id = insertHabitRow(habit.getName());
+        if (id != -1)
+            habit.completions().forEach([&](date::Day d) { writeCompletion(id, d, true); });
+        adoptSlot(std::move(habit), id);
+        ++added;
+    }
+    if (own) {
+        flush();
+        batching_ = false;
+        batchMaxOps_ = oldMaxOps;
+        batchMaxDelay_ = oldMaxDelay;
+    }
+    return added;
 }
 
-Habit* HabitManager::find(const std::string& name) {
-    for (auto& h : habits_)
-        if (h.getName() == name) return &h;
-    return nullptr;
+int HabitManager::insertHabitRow(std::string_view name) {
+    return storage_ ? storage_->addHabit(std::string(name)) : -1;
 }
-const Habit* HabitManager::find(const std::string& name) const {
-    for (const auto& h : habits_)
-        if (h.getName() == name) return &h;
-    return nullptr;
+
+void HabitManager::addSlot(std::string_view name, int id) {
+    adoptSlot(Habit(name), id);
 }
 
-// helper to get habit id from DB
-int HabitManager::getHabitId(const std::string& name) {
-    if (!db_) return -1;
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id FROM habits WHERE name=?;";
-    int id = -1;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            id = sqlite3_column_int(stmt, 0);
-        }
-        sqlite3_finalize(stmt);
+void HabitManager::adoptSlot(Habit&& habit, int id) {
+    Version& v = edit();
+    indexName(habit.getName(), v.size);
+    if (v.size % HabitSnapshot::kChunk == 0) {
+        v.chunks.push_back(makePooled<HabitSnapshot::Chunk>());
+        v.chunks.back()->reserve(HabitSnapshot::kChunk);
     }
-    return id;
+    unshare(v.chunks.back()).push_back(makePooled<Habit>(std::move(habit)));
+    ++v.size;
+    ids_.push_back(-1);
+    setId(v.size - 1, id);
+}
+
+// One shard (and the shard table) is copied per add; when the shards fill up
+// their count doubles and every name is rehashed once, so adds stay O(1)
+// amortized however many habits there are.
+void HabitManager::indexName(std::string_view name, std::size_t slot) {
+    HabitSnapshot::Index& index = unshare(edit().index);
+    if (index.size >= index.shards.size() * HabitSnapshot::kShardLoad) reserveIndex(index.size + 1);
+    unshare(index.shards[index.shardOf(name)]).emplace(name, slot);
+    ++index.size;
+}
+
+// enough shards for `names` names; fresh shards, so nothing is shared
+void HabitManager::reserveIndex(std::size_t names) {
+    HabitSnapshot::Index& index = unshare(edit().index);
+    std::size_t n = index.shards.empty() ? 1 : index.shards.size();
+    while (n * HabitSnapshot::kShardLoad < names) n *= 2;
+    if (n == index.shards.size()) return;
+
+    decltype(index.shards) shards;
+    shards.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        shards.push_back(makePooled<HabitSnapshot::Shard>());
+        shards.back()->reserve(HabitSnapshot::kShardLoad);
+    }
+    for (const auto& shard : index.shards)
+        for (const auto& entry : *shard)
+            shards[HabitSnapshot::Index::hash(entry.first) & (n - 1)]->insert(entry);
+    index.shards = std::move(shards);
+}
+
+void HabitManager::setId(std::size_t slot, int id) {
+    ids_[slot] = id;
+    if (id != -1) slotById_[id] = slot;
+}
+
+// a fresh, empty version; readers holding the old one keep it
+void HabitManager::clearSlots() {
+    std::uint32_t generation = latest().generation + 1;
+    draft_ = makePooled<Version>();
+    draft_->index = makePooled<HabitSnapshot::Index>();
+    draft_->generation = generation;
+    ids_.clear();
+    slotById_.clear();
+}
+
+std::size_t HabitManager::slotOf(std::string_view name) const {
+    HABIT_TIMER(kLookup);
+    return latest().index->find(name);
+}
+
+std::shared_ptr<const Habit> HabitManager::find(std::string_view name) const {
+    HABIT_TIMER(kLookup);
+    std::lock_guard<std::mutex> lock(publishMu_);
+    std::size_t slot = current_->index->find(name);
+    if (slot == npos) return nullptr;
+    return (*current_->chunks[slot / HabitSnapshot::kChunk])[slot % HabitSnapshot::kChunk];
+}
+
+HabitHandle HabitManager::handleOf(std::string_view name) const {
+    return getHabits().handleOf(name);
+}
+
+// Habits that came from storage or were added through it already know their
+// id; only habits loaded from JSON need the one-off query.
+int HabitManager::habitId(std::size_t slot) {
+    if (!storage_ || ids_[slot] != -1) return ids_[slot];
+    setId(slot, storage_->findHabitId(std::string(habitAt(slot).getName())));
+    return ids_[slot];
 }
 
 // ----------------- Listing & Reporting -----------------
 
 void HabitManager::list() const {
-    if (habits_.empty()) { std::cout << "(no habits yet)\n"; return; }
-    for (const auto& h : habits_) {
+    HabitSnapshot habits = getHabits();
+    if (habits.empty()) { std::cout << "(no habits yet)\n"; return; }
+    date::Day today = date::today();
+    for (const auto& h : habits) {
         std::cout << "- " << h.getName()
-                  << " | streak: " << h.currentStreak()
-                  << (h.isCompletedOn(Habit::todayISO()) ? " | done today" : " | not done")
+                  << " | streak: " << h.currentStreak(today)
+                  << (h.isCompletedOn(today) ? " | done today" : " | not done")
                   << "\n";
     }
 }
 
-void HabitManager::weeklyReport() const {
-    if (habits_.empty()) { std::cout << "(no habits)\n"; return; }
-
-    std::cout << "\n=== Weekly Report (last 7 days) ===\n";
-    auto now = std::chrono::system_clock::now();
+// Multi-week report built on stats(): one line of ✔/✘ per week, oldest first.
+void HabitManager::weeklyReport(int weeks) const {
+    HabitSnapshot habits = getHabits();
+    if (habits.empty()) { std::cout << "(no habits)\n"; return; }
+    if (weeks < 1) weeks = 1;
+
+    date::Day today = date::today();
+    date::Day from = today - 7 * weeks + 1;
+    std::cout << "\n=== Weekly Report (last " << 7 * weeks << " days) ===\n";
+
+    std::vector<HabitStats> all = stats(habits, from, today);
+    for (std::size_t i = 0; i < habits.size(); ++i) {
+        const HabitStats& st = all[i];
+        std::cout << st.name << " | streak: " << st.currentStreak
+                  << " | " << st.completed << "/" << st.days << "\n";
+
+        for (int w = 0; w < weeks; ++w) {
+            std::uint64_t bits = habits[i].completions().window(from + 7 * w, 7);
+            std::cout << "  ";
+            for (int d = 0; d < 7; ++d) std::cout << ((bits >> d) & 1u ? "✔ " : "✘ ");
+            std::cout << "\n";
+        }
+    }
+}
 
-    for (const auto& h : habits_) {
-        std::cout << h.getName() << " | streak: " << h.currentStreak() << "\n  ";
+// ----------------- Analytics -----------------
 
-        for (int i = 6; i >= 0; --i) {
-            auto t  = now - std::chrono::hours(24 * i);
-            std::time_t tt = std::chrono::system_clock::to_time_t(t);
-            std::tm tm = *std::localtime(&tt);
+std::vector<HabitStats> HabitManager::stats(date::Day from, date::Day to) const {
+    return stats(getHabits(), from, to);
+}
 
-            char buf[11];
-            std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
-            std::string date = buf;
+std::vector<HabitStats> HabitManager::stats(const HabitSnapshot& habits, date::Day from, date::Day to) {
+    std::vector<HabitStats> out(habits.size());
+    parallelFor(habits.size(), [&](std::size_t i) { out[i] = habitStats(habits[i], from, to); });
+    return out;
+}
 
-            std::cout << (h.isCompletedOn(date) ? "✔ " : "✘ ");
-        }
-        std::cout << "\n";
-    }
+bool HabitManager::heatmap(std::string_view name, int year, YearHeatmap& out) const {
+    std::shared_ptr<const Habit> h = find(name);
+    if (!h) return false;
+    out = yearHeatmap(*h, year);
+    return true;
 }
 
 // ----------------- Marking -----------------
 
-bool HabitManager::markCompleteToday(const std::string& name) {
-    auto* h = find(name);
-    if (!h) { std::cout << "(not found)\n"; return false; }
-    h->markCompleteToday();
-
-    // also insert completion into DB
-    if (db_) {
-        int habit_id = getHabitId(name);
-        if (habit_id != -1) {
-            std::string today = Habit::todayISO();
-            sqlite3_stmt* stmt;
-            const char* sql = "INSERT OR REPLACE INTO completions(habit_id,date) VALUES(?,?);";
-            if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-                sqlite3_bind_int(stmt, 1, habit_id);
-                sqlite3_bind_text(stmt, 2, today.c_str(), -1, SQLITE_STATIC);
-                sqlite3_step(stmt);
-                sqlite3_finalize(stmt);
-            }
-        }
-    }
-
+bool HabitManager::markCompleteToday(std::string_view name) {
+    WriteLock lock(*this);
+    std::size_t slot = slotOf(name);
+    if (slot == npos) { std::cout << "(not found)\n"; return false; }
+    setSlot(slot, date::today(), true);
     std::cout << "Marked today complete: " << name << "\n";
     return true;
 }
 
-bool HabitManager::setToday(const std::string& name, bool done) {
-    auto* h = find(name);
-    if (!h) { std::cout << "(not found)\n"; return false; }
-    if (done) h->markCompleteToday();
-    else      h->unmarkToday();
-
-    // also update DB completions
-    if (db_) {
-        int habit_id = getHabitId(name);
-        std::string today = Habit::todayISO();
-        if (done) {
-            sqlite3_exec(db_, ("INSERT OR REPLACE INTO completions(habit_id,date) "
-                               "VALUES(" + std::to_string(habit_id) + ",'" + today + "');").c_str(),
-                         nullptr, nullptr, nullptr);
-        } else {
-            sqlite3_exec(db_, ("DELETE FROM completions WHERE habit_id=" +
-                               std::to_string(habit_id) + " AND date='" + today + "';").c_str(),
-                         nullptr, nullptr, nullptr);
-        }
-    }
+bool HabitManager::setToday(std::string_view name, bool done) {
+    WriteLock lock(*this);
+    std::size_t slot = slotOf(name);
+    if (slot == npos) { std::cout << "(not found)\n"; return false; }
+    setSlot(slot, date::today(), done);
+    return true;
+}
+
+bool HabitManager::setToday(HabitHandle habit, bool done) {
+    return setCompletedOn(habit, date::today(), done);
+}
 
+bool HabitManager::setCompletedOn(HabitHandle habit, date::Day day, bool done) {
+    WriteLock lock(*this);
+    std::size_t slot = HabitSnapshot::slotOf(habit, latest().generation, latest().size);
+    if (slot == npos) return false;                    // stale handle
+    setSlot(slot, day, done);
     return true;
 }
 
+int HabitManager::setCompletedRange(HabitHandle habit, date::Day from, date::Day to, bool done) {
+    WriteLock lock(*this);
+    std::size_t slot = HabitSnapshot::slotOf(habit, latest().generation, latest().size);
+    if (slot == npos || static_cast<std::int64_t>(to) - from >= Habit::kMaxRangeDays) return -1;
+    if (to < from) return 0;
+    // only the days that change go to the DB; nothing changes, nothing is copied
+    const Habit& h = habitAt(slot);
+    if (done ? h.completions().count(from, to) == to - from + 1 : h.completions().count(from, to) == 0)
+        return 0;
+    std::vector<date::Day> changed;
+    editHabit(slot).setCompletedRange(from, to, done, &changed);
+    writeCompletions(habitId(slot), changed, done);
+    return static_cast<int>(changed.size());
+}
+
+int HabitManager::setCompletedDays(HabitHandle habit, std::vector<date::Day> days, bool done) {
+    WriteLock lock(*this);
+    std::size_t slot = HabitSnapshot::slotOf(habit, latest().generation, latest().size);
+    if (slot == npos) return -1;
+    std::sort(days.begin(), days.end());
+    days.erase(std::unique(days.begin(), days.end()), days.end());
+    const Habit& h = habitAt(slot);
+    days.erase(std::remove_if(days.begin(), days.end(),
+                              [&](date::Day d) { return h.isCompletedOn(d) == done; }),
+               days.end());
+    if (days.empty()) return 0;
+    editHabit(slot).setCompletedDays(days, done);
+    writeCompletions(habitId(slot), days, done);
+    return static_cast<int>(days.size());
+}
+
+// update the habit, then the DB completions
+void HabitManager::setSlot(std::size_t slot, date::Day day, bool done) {
+    editHabit(slot).setCompletedOn(day, done);
+    writeCompletion(habitId(slot), day, done);
+}
+
 // ----------------- Persistence (JSON export still works) -----------------
 
-bool HabitManager::save(const std::string& path) const {
-    json j = json::array();
-    for (const auto& h : habits_) j.push_back(h.toJson());
+bool HabitManager::save(const std::string& path, bool compact) const {
     std::ofstream out(path);
     if (!out) { std::cout << "Could not open " << path << " for write.\n"; return false; }
-    out << j.dump(2);
+    HABIT_TIMER_NAMED(timer, kJsonSave);
+    HabitJsonWriter writer(out, compact);
+    for (const auto& h : getHabits()) writer.write(h);
+    writer.finish();
+    HABIT_TIMER_BYTES(timer, static_cast<std::uint64_t>(out.tellp()));
     std::cout << "Saved to " << path << "\n";
     return true;
 }
@@ -198,30 +524,206 @@ bool HabitManager::save(const std::string& path) const {
 bool HabitManager::load(const std::string& path) {
     std::ifstream in(path);
     if (!in) { std::cout << "No existing data at " << path << " (starting fresh)\n"; return false; }
-    json j; in >> j;
-    habits_.clear();
-    for (const auto& item : j) habits_.push_back(Habit::fromJson(item));
-    std::cout << "Loaded " << habits_.size() << " habit(s) from " << path << "\n";
-    return true;
+    WriteLock lock(*this);
+    clearSlots();
+    HABIT_TIMER_NAMED(timer, kJsonLoad);
+    bool ok = readHabitJson(in, [&](Habit&& h) {
+        if (slotOf(h.getName()) != npos) return;          // names are unique
+        adoptSlot(std::move(h), -1);
+    });
+    HABIT_TIMER_BYTES(timer, static_cast<std::uint64_t>((in.clear(), in.tellg())));
+    std::size_t n = latest().size;
+    if (!ok) std::cout << "Could not parse " << path << " (kept " << n << " habit(s))\n";
+    else     std::cout << "Loaded " << n << " habit(s) from " << path << "\n";
+    return ok;
+}
+
+// ----------------- Bulk import -----------------
+
+bool HabitManager::importFile(const std::string& path, const ImportOptions& opts, ImportStats* stats) {
+    ImportStats local;
+    ImportStats& st = stats ? *stats : local;
+    WriteLock lock(*this);
+
+    // write straight through this connection in big transactions; the async
+    // writer (if any) is drained and parked until the import is done
+    std::unique_ptr<AsyncWriter> parked = std::move(writer_);
+    if (parked) parked->drain();
+    bool wasBatching = batching_;
+    std::size_t oldMaxOps = batchMaxOps_;
+    std::chrono::milliseconds oldMaxDelay = batchMaxDelay_;
+    flush();
+    if (storage_) storage_->setBulk(true);
+    // batch settings are swapped directly: endBatch() would join the batch
+    // timer, which waits for the writeMu_ held here
+    batching_ = true;
+    batchMaxOps_ = opts.batchRows;
+    batchMaxDelay_ = std::chrono::hours(1);
+    if (storage_) startTxn();
+
+    // readers see the import grow chunk by chunk
+    bool ok = parseImport(path, opts, st, [&](ImportChunk&& chunk) {
+        mergeImported(std::move(chunk), st);
+        publish();
+    });
+
+    flush();
+    if (storage_) storage_->setBulk(false);
+    batching_ = wasBatching;
+    batchMaxOps_ = oldMaxOps;
+    batchMaxDelay_ = oldMaxDelay;
+    writer_ = std::move(parked);
+
+    std::cout << "Imported " << st.added << " completion(s) (" << st.duplicates << " duplicate, "
+              << st.badRows << " bad) into " << st.habitsAdded << " new and " << st.habitsMerged
+              << " existing habit(s) from " << path << "\n";
+    return ok;
+}
+
+// New habits are adopted whole; existing ones gain only the days they lack.
+void HabitManager::mergeImported(ImportChunk&& chunk, ImportStats& stats) {
+    for (Habit& h : chunk.habits) {
+        std::string_view name = h.getName();           // interned, outlives h
+        std::size_t slot = slotOf(name);
+        if (slot == npos) {
+            int id = insertHabitRow(name);
+            if (id == -1 && storage_) id = storage_->findHabitId(std::string(name));
+            h.completions().forEach([&](date::Day d) { writeCompletion(id, d, true); });
+            stats.added += h.completions().count();
+            ++stats.habitsAdded;
+            adoptSlot(std::move(h), id);
+            continue;
+        }
+
+        int id = habitId(slot);
+        if (id == -1 && storage_) setId(slot, id = insertHabitRow(name));
+        const Habit* dst = &habitAt(slot);
+        std::uint64_t before = stats.added;
+        h.completions().forEach([&](date::Day d) {
+            if (dst->isCompletedOn(d)) { ++stats.duplicates; return; }
+            Habit& edited = editHabit(slot);      // copied once, on the first new day
+            edited.setCompletedOn(d, true);
+            dst = &edited;
+            writeCompletion(id, d, true);
+            ++stats.added;
+        });
+        stats.habitsMerged += stats.added != before;
+    }
 }
 
 // ----------------- Accessor for UI -----------------
+// The backend streams habits in id order, each followed by its completions,
+// so every new id opens a slot and its days go straight into that bitmap.
 bool HabitManager::loadFromDB() {
-    if (!db_) return false;
-    habits_.clear();
-
-    const char* sql = "SELECT name FROM habits;";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            std::string name =
-                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            habits_.emplace_back(name);
-            // later you can also read completions here if needed
+    WriteLock lock(*this);
+    if (!storage_) return false;
+    bool ok = reloadFromStorage();
+    std::cout << "Loaded " << draft_->size << " habit(s) from DB.\n";
+    return ok;
+}
+
+// Changes committed between taking the cursor and loadAll() are replayed by
+// the next refresh; every change sets a final state, so that is harmless.
+bool HabitManager::reloadFromStorage() {
+    HABIT_TIMER(kDbLoad);
+    clearSlots();
+    storage_->externallyChanged();
+    changeCursor_ = storage_->changeCursor();
+
+    struct Loader : Storage::Sink {
+        HabitManager& m;
+        Habit* current = nullptr;
+        explicit Loader(HabitManager& manager) : m(manager) {}
+
+        void reserve(std::size_t n) override {
+            m.draft_->chunks.reserve(n / HabitSnapshot::kChunk + 1);
+            m.reserveIndex(n);
+            m.ids_.reserve(n);
+        }
+        void habit(int id, const std::string& name) override {
+            m.addSlot(name, id);
+            current = m.draft_->chunks.back()->back().get();
+        }
+        void completion(int, date::Day day) override { current->setCompletedOn(day, true); }
+        void completionWords(int, date::Day base, const std::uint64_t* words, std::size_t n) override {
+            current->setCompletedWords(base, words, n);
+        }
+    } loader(*this);
+
+    return storage_->loadAll(loader);
+}
+
+// ----------------- Watching -----------------
+
+bool HabitManager::refreshFromDB() {
+    WriteLock lock(*this);
+    if (!storage_) return false;
+    // The async writer's connection counts as another connection. Draining
+    // it first (nothing can be queued meanwhile: pushes need writeMu_) means
+    // the feed is never behind memory for this process's own writes, so
+    // replaying it cannot briefly revert a toggle that is still queued.
+    if (writer_) writer_->drain();
+    if (!storage_->externallyChanged()) return false;
+
+    // days already in the wanted state (this app's own writes, replays)
+    // are skipped without copying the habit
+    struct Applier : Storage::ChangeSink {
+        HabitManager& m;
+        bool changed = false;
+        explicit Applier(HabitManager& manager) : m(manager) {}
+
+        void habit(int id, const std::string& name) override {
+            if (m.slotById_.count(id)) return;
+            std::size_t slot = m.slotOf(name);
+            if (slot != npos) { m.setId(slot, id); return; }
+            m.addSlot(name, id);
+            changed = true;
+        }
+        void completion(int id, date::Day day, bool done) override {
+            auto it = m.slotById_.find(id);
+            if (it == m.slotById_.end() || m.habitAt(it->second).isCompletedOn(day) == done) return;
+            m.editHabit(it->second).setCompletedOn(day, done);
+            changed = true;
         }
-        sqlite3_finalize(stmt);
+    } applier(*this);
+
+    if (storage_->readChanges(changeCursor_, applier)) return applier.changed;
+    reloadFromStorage();                   // replaces any partial delta
+    return true;
+}
+
+// Events only say a file was written; the data_version check in
+// refreshFromDB() decides whether anything was committed. A commit can land
+// just after an event is handled, so the first quiet timeout after activity
+// checks once more. Without inotify this degrades to polling.
+bool HabitManager::startWatching(std::function<void()> onChange) {
+    stopWatching();
+    std::string path;
+    {
+        std::lock_guard<std::recursive_mutex> lock(writeMu_);
+        if (storage_) path = storage_->watchPath();
     }
-    std::cout << "Loaded " << habits_.size() << " habit(s) from DB.\n";
+    if (path.empty()) return false;
+
+    watcher_ = std::make_unique<FileWatcher>(path);
+    watchStop_ = false;
+    watchThread_ = std::thread([this, onChange = std::move(onChange)] {
+        const auto recheck = std::chrono::milliseconds(100);
+        bool active = false;
+        while (!watchStop_) {
+            bool event = watcher_->wait(recheck);
+            if (watchStop_) break;
+            if ((event || active || !watcher_->watching()) && refreshFromDB() && onChange) onChange();
+            active = event;
+        }
+    });
     return true;
 }
 
+void HabitManager::stopWatching() {
+    if (!watchThread_.joinable()) return;
+    watchStop_ = true;
+    watcher_->wake();
+    watchThread_.join();
+    watcher_.reset();
+}
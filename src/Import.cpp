@@ -0,0 +1,369 @@
+#include "Import.h"
+#include "HabitJson.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+// ----------------- Splitting -----------------
+// Cuts the mapped file into spans of roughly `want` bytes that end on a
+// record boundary. Runs on its own thread ahead of the parsers.
+
+struct Span {
+    const char* first;
+    const char* last;
+};
+
+class CsvSplitter {
+public:
+    CsvSplitter(const char* p, const char* end) : pos_(p), end_(end) {}
+
+    bool next(std::size_t want, Span& out) {
+        if (pos_ == end_) return false;
+        const char* cut = end_;
+        if (static_cast<std::size_t>(end_ - pos_) > want) {
+            const void* nl = std::memchr(pos_ + want, '\n', static_cast<std::size_t>(end_ - pos_ - want));
+            if (nl) cut = static_cast<const char*>(nl) + 1;
+        }
+        out = Span{pos_, cut};
+        pos_ = cut;
+        return true;
+    }
+    bool ok() const { return true; }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+// Spans hold whole elements of the top-level array ("{...},{...}") and are
+// parsed as an array of their own; only strings and nesting are tracked.
+class JsonSplitter {
+public:
+    JsonSplitter(const char* p, const char* end) : pos_(p), end_(end) {
+        while (pos_ < end_ && std::isspace(static_cast<unsigned char>(*pos_))) ++pos_;
+        if (pos_ < end_ && *pos_ == '[') ++pos_;
+        else ok_ = false;
+    }
+
+    bool next(std::size_t want, Span& out) {
+        if (!ok_ || done_) return false;
+        while (pos_ < end_ && (std::isspace(static_cast<unsigned char>(*pos_)) || *pos_ == ',')) ++pos_;
+        const char* first = pos_;
+        int depth = 0;
+        for (const char* p = pos_; p < end_; ++p) {
+            char c = *p;
+            if (c == '"') {
+                for (++p; p < end_ && *p != '"'; ++p)
+                    if (*p == '\\') ++p;
+            } else if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (depth == 0) {                   // the closing ']' of the array
+                    done_ = true;
+                    pos_ = end_;
+                    out = Span{first, p};
+                    return p > first;
+                }
+                --depth;
+            } else if (c == ',' && depth == 0 && static_cast<std::size_t>(p - first) >= want) {
+                out = Span{first, p};
+                pos_ = p + 1;
+                return true;
+            }
+        }
+        ok_ = false;                                // ran off the end: unterminated
+        return false;
+    }
+    bool ok() const { return ok_; }
+
+private:
+    const char* pos_;
+    const char* end_;
+    bool ok_ = true;
+    bool done_ = false;
+};
+
+// ----------------- Parsing -----------------
+
+// Chunk-local habits by name; rows for one habit usually arrive together,
+// so the last one is checked before the map.
+class ChunkBuilder {
+public:
+    explicit ChunkBuilder(ImportChunk& chunk) : chunk_(chunk) {}
+
+    Habit& habit(const char* name, std::size_t len) {
+        std::string_view key(name, len);
+        if (last_ != npos && chunk_.habits[last_].getName() == key) return chunk_.habits[last_];
+        auto it = slot_.find(key);
+        if (it == slot_.end()) {
+            chunk_.habits.emplace_back(key);
+            it = slot_.emplace(chunk_.habits.back().getName(), chunk_.habits.size() - 1).first;
+        }
+        last_ = it->second;
+        return chunk_.habits[last_];
+    }
+
+    void add(Habit&& h) {
+        auto it = slot_.find(h.getName());
+        if (it == slot_.end()) {
+            chunk_.rows += h.completions().count();
+            slot_.emplace(h.getName(), chunk_.habits.size());
+            chunk_.habits.push_back(std::move(h));
+            return;
+        }
+        Habit& dst = chunk_.habits[it->second];
+        h.completions().forEach([&](date::Day d) { mark(dst, d); });
+    }
+
+    void mark(Habit& h, date::Day d) {
+        ++chunk_.rows;
+        if (h.isCompletedOn(d)) { ++chunk_.duplicates; return; }
+        h.setCompletedOn(d, true);
+    }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    ImportChunk& chunk_;
+    std::unordered_map<std::string_view, std::size_t> slot_;   // keyed by interned names
+    std::size_t last_ = npos;
+};
+
+// "2024-03-01", optionally followed by a time
+bool parseDateField(const char* p, std::size_t n, date::Day& day) {
+    if (n > 10 && (p[10] == 'T' || p[10] == ' ')) n = 10;
+    return date::parseISO(p, n, day);
+}
+
+bool falsy(const char* p, std::size_t n) {
+    return n > 0 && (*p == '0' || *p == 'f' || *p == 'F' || *p == 'n' || *p == 'N');
+}
+
+void trim(const char*& p, const char*& e) {
+    while (p < e && (*p == ' ' || *p == '\t')) ++p;
+    while (e > p && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) --e;
+}
+
+void parseCsv(Span span, bool firstChunk, ImportChunk& chunk) {
+    ChunkBuilder builder(chunk);
+    std::string unquoted;
+    bool firstLine = firstChunk;
+    for (const char* p = span.first; p < span.last;) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(span.last - p)));
+        if (!eol) eol = span.last;
+        const char* line = p;
+        p = eol + 1;
+        bool header = firstLine;
+        firstLine = false;
+
+        const char* e = eol;
+        trim(line, e);
+        if (line == e) continue;
+
+        // name
+        const char* name;
+        std::size_t nameLen;
+        const char* q = line;
+        if (*q == '"') {
+            unquoted.clear();
+            for (++q; q < e; ++q) {
+                if (*q == '"') {
+                    if (q + 1 < e && q[1] == '"') { unquoted += '"'; ++q; }
+                    else break;
+                } else {
+                    unquoted += *q;
+                }
+            }
+            if (q >= e) { chunk.badRows += !header; continue; }
+            name = unquoted.data();
+            nameLen = unquoted.size();
+            ++q;
+            while (q < e && *q != ',') ++q;
+        } else {
+            while (q < e && *q != ',') ++q;
+            const char* ne = q;
+            const char* nb = line;
+            trim(nb, ne);
+            name = nb;
+            nameLen = static_cast<std::size_t>(ne - nb);
+        }
+        if (q >= e || nameLen == 0) { chunk.badRows += !header; continue; }
+
+        // date, then the optional done column
+        const char* d = ++q;
+        while (q < e && *q != ',') ++q;
+        const char* de = q;
+        trim(d, de);
+        date::Day day;
+        if (!parseDateField(d, static_cast<std::size_t>(de - d), day)) {
+            chunk.badRows += !header;
+            continue;
+        }
+        if (q < e) {
+            const char* f = q + 1;
+            const char* fe = e;
+            trim(f, fe);
+            if (falsy(f, static_cast<std::size_t>(fe - f))) continue;
+        }
+        builder.mark(builder.habit(name, nameLen), day);
+    }
+}
+
+bool parseJson(Span span, ImportChunk& chunk) {
+    std::string text;
+    text.reserve(static_cast<std::size_t>(span.last - span.first) + 2);
+    text += '[';
+    text.append(span.first, span.last);
+    text += ']';
+    ChunkBuilder builder(chunk);
+    return readHabitJson(text.data(), text.data() + text.size(),
+                         [&](Habit&& h) { builder.add(std::move(h)); });
+}
+
+// ----------------- Pipeline -----------------
+
+struct Slot {
+    Span span;
+    ImportChunk chunk;
+    bool ready = false;
+    bool ok = true;
+};
+
+template <typename Splitter>
+bool runPipeline(Splitter& splitter, bool csv, const MappedFile& file, const ImportOptions& opts,
+                 ImportStats& stats, const std::function<void(ImportChunk&&)>& onChunk) {
+    unsigned threads = opts.threads ? opts.threads : std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t window = 4 * static_cast<std::size_t>(threads);   // chunks in flight
+    const std::size_t want = std::max<std::size_t>(opts.chunkBytes, 1);
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<Slot> slots;           // grows as the splitter runs; reserved so it never moves
+    slots.reserve(file.size() / want + 2);
+    bool splitDone = false;
+    std::size_t nextParse = 0, merged = 0;
+
+    std::thread producer([&] {
+        Span span;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mu);
+                cv.wait(lock, [&] { return slots.size() - merged < window; });
+            }
+            if (!splitter.next(want, span)) break;
+            std::lock_guard<std::mutex> lock(mu);
+            slots.push_back(Slot{span, ImportChunk{}, false, true});
+            cv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        splitDone = true;
+        cv.notify_all();
+    });
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            while (true) {
+                std::size_t i;
+                {
+                    std::unique_lock<std::mutex> lock(mu);
+                    cv.wait(lock, [&] { return nextParse < slots.size() || splitDone; });
+                    if (nextParse == slots.size()) return;
+                    i = nextParse++;
+                }
+                Slot& slot = slots[i];
+                slot.chunk.bytes = static_cast<std::uint64_t>(slot.span.last - slot.span.first);
+                if (csv) parseCsv(slot.span, slot.span.first == file.data(), slot.chunk);
+                else     slot.ok = parseJson(slot.span, slot.chunk);
+                std::lock_guard<std::mutex> lock(mu);
+                slot.ready = true;
+                cv.notify_all();
+            }
+        });
+    }
+
+    // merge in file order on this thread while the pool keeps parsing
+    auto t0 = std::chrono::steady_clock::now();
+    auto lastReport = t0;
+    auto report = [&] {
+        if (!opts.onProgress) return;
+        lastReport = std::chrono::steady_clock::now();
+        opts.onProgress(ImportProgress{stats.bytes, file.size(), stats.rows,
+                                       std::chrono::duration<double>(lastReport - t0).count()});
+    };
+
+    bool ok = true;
+    for (std::size_t k = 0;; ++k) {
+        ImportChunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            while (!((k < slots.size() && slots[k].ready) || (splitDone && k == slots.size()))) {
+                if (cv.wait_for(lock, opts.progressEvery) == std::cv_status::timeout) {
+                    lock.unlock();
+                    report();
+                    lock.lock();
+                }
+            }
+            if (k == slots.size()) break;
+            chunk = std::move(slots[k].chunk);
+            ok = ok && slots[k].ok;
+        }
+        stats.bytes += chunk.bytes;
+        stats.rows += chunk.rows;
+        stats.duplicates += chunk.duplicates;
+        stats.badRows += chunk.badRows;
+        onChunk(std::move(chunk));
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            merged = k + 1;
+        }
+        cv.notify_all();
+        if (std::chrono::steady_clock::now() - lastReport >= opts.progressEvery) report();
+    }
+
+    producer.join();
+    for (auto& w : workers) w.join();
+    report();
+    return ok && splitter.ok();
+}
+
+} // namespace
+
+bool parseImport(const std::string& path, const ImportOptions& opts, ImportStats& stats,
+                 const std::function<void(ImportChunk&&)>& onChunk) {
+    auto t0 = std::chrono::steady_clock::now();
+    MappedFile file(path);
+    if (!file.data()) {
+        std::cout << "Could not read " << path << "\n";
+        return false;
+    }
+
+    ImportFormat format = opts.format;
+    if (format == ImportFormat::Auto) {
+        bool csvName = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        const char* p = file.data();
+        const char* end = p + file.size();
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) ++p;
+        format = !csvName && p < end && *p == '[' ? ImportFormat::Json : ImportFormat::Csv;
+    }
+
+    bool ok;
+    const char* end = file.data() + file.size();
+    if (format == ImportFormat::Csv) {
+        CsvSplitter splitter(file.data(), end);
+        ok = runPipeline(splitter, true, file, opts, stats, onChunk);
+    } else {
+        JsonSplitter splitter(file.data(), end);
+        ok = runPipeline(splitter, false, file, opts, stats, onChunk);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return ok;
+}
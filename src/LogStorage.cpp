@@ -0,0 +1,404 @@
+#include "Storage.h"
+#include "CompletionBitmap.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Append-only event log. The file is a 16-byte header followed by 16-byte
+// records in native byte order:
+//
+//   uint32 habitId | int32 day | uint8 op | 3 bytes zero | uint32 check
+//
+// kAddHabit carries the name length in `day` and is followed by
+// ceil(len / 8) kName records whose first 8 bytes are name bytes. `check` is
+// FNV-1a over the first 12 bytes, so a torn or zero-filled tail fails it and
+// open() truncates the file back to the last complete record.
+//
+// Appends are plain write()s (no fsync per record), which survives a process
+// crash like SQLite's WAL with synchronous=NORMAL; fdatasync() runs when the
+// log is compacted and on close.
+//
+// There is one writer: ids are handed out from what this process scanned, so
+// open() takes an exclusive flock() and fails while another handle holds it.
+//
+// The log is compacted (rewritten as one kAddHabit per habit plus a kSet per
+// completed day) once it holds more than 2x the live records plus
+// kCompactSlack: checked by loadAll() and, as appends grow the file past the
+// last count of live records, by rescanning the file after a write.
+
+namespace {
+
+constexpr char kMagic[8] = {'H', 'B', 'T', 'L', 'O', 'G', '0', '1'};
+constexpr std::size_t kHeaderSize = 16;
+constexpr std::size_t kRecordSize = 16;
+constexpr std::size_t kNameChunk = 8;
+constexpr std::size_t kCompactSlack = 4096;   // records of garbage tolerated on top of 2x live
+
+enum Op : std::uint8_t { kSet = 1, kClear = 2, kAddHabit = 3, kName = 4 };
+
+struct Record {
+    std::uint32_t habitId;
+    std::int32_t  day;
+    std::uint8_t  op;
+    std::uint8_t  pad[3];
+    std::uint32_t check;
+};
+static_assert(sizeof(Record) == kRecordSize, "log records are 16 bytes");
+
+std::uint32_t checksum(const Record& r) {
+    const auto* p = reinterpret_cast<const unsigned char*>(&r);
+    std::uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < offsetof(Record, check); ++i) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+Record makeRecord(std::uint32_t habitId, std::int32_t day, Op op) {
+    Record r{habitId, day, op, {0, 0, 0}, 0};
+    r.check = checksum(r);
+    return r;
+}
+
+void appendRecord(std::string& buf, const Record& r) {
+    buf.append(reinterpret_cast<const char*>(&r), sizeof r);
+}
+
+// kAddHabit plus its name chunks, ready to be written in one go
+void appendHabit(std::string& buf, int id, const std::string& name) {
+    appendRecord(buf, makeRecord(static_cast<std::uint32_t>(id),
+                                 static_cast<std::int32_t>(name.size()), kAddHabit));
+    for (std::size_t off = 0; off < name.size(); off += kNameChunk) {
+        Record r{0, 0, kName, {0, 0, 0}, 0};
+        std::memcpy(&r, name.data() + off, std::min(kNameChunk, name.size() - off));
+        r.check = checksum(r);
+        appendRecord(buf, r);
+    }
+}
+
+bool writeAll(int fd, const char* p, std::size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+class LogStorage : public Storage {
+public:
+    ~LogStorage() override {
+        if (fd_ < 0) return;
+        commit();
+        fdatasync(fd_);
+        ::close(fd_);
+    }
+
+    bool open(const std::string& path) override {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            std::cerr << "Cannot open log " << path << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        path_ = path;
+        if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+            if (errno == EWOULDBLOCK) {
+                std::cerr << "Log " << path << " is in use by another process\n";
+                ::close(fd_);
+                fd_ = -1;
+                return false;
+            }
+            return fail("lock");
+        }
+
+        // the size comes from fstat: a mapping that fails also has size 0,
+        // and must not be taken for an empty file
+        struct stat st;
+        if (fstat(fd_, &st) != 0) return fail("stat");
+        char header[kHeaderSize] = {};
+        std::memcpy(header, kMagic, sizeof kMagic);
+        std::size_t valid;
+        if (static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+            // new, or the first header write never finished: what is there
+            // has to be the start of the header
+            char head[kHeaderSize];
+            std::size_t n = static_cast<std::size_t>(st.st_size);
+            if (n && (::pread(fd_, head, n, 0) != static_cast<ssize_t>(n) ||
+                      std::memcmp(head, header, n) != 0)) {
+                std::cerr << "Not a habit log: " << path << "\n";
+                ::close(fd_);
+                fd_ = -1;
+                return false;
+            }
+            if (ftruncate(fd_, 0) != 0 || !writeAll(fd_, header, sizeof header)) return fail("write header");
+            valid = kHeaderSize;
+        } else {
+            MappedFile map(fd_);
+            if (!map.data()) return fail("map");
+            if (std::memcmp(map.data(), kMagic, sizeof kMagic) != 0) {
+                std::cerr << "Not a habit log: " << path << "\n";
+                ::close(fd_);
+                fd_ = -1;
+                return false;
+            }
+            valid = scan(map, nullptr);
+            if (valid < map.size())
+                std::cerr << "Log " << path << ": dropped " << (map.size() - valid)
+                          << " byte(s) of torn records\n";
+        }
+        // cut a torn tail so new records follow the last complete one
+        if (ftruncate(fd_, static_cast<off_t>(valid)) != 0) return fail("truncate");
+        if (lseek(fd_, 0, SEEK_END) < 0) return fail("seek");
+        records_ = live_ = (valid - kHeaderSize) / kRecordSize;   // live is counted by loadAll()
+        return true;
+    }
+
+    // Replay the log into per-habit bitmaps, hand the result to the sink and
+    // compact if most of the file is superseded records.
+    bool loadAll(Sink& sink) override {
+        if (fd_ < 0) return false;
+        commit();
+        std::vector<Entry> entries;
+        if (!scanAll(entries)) return false;
+
+        sink.reserve(entries.size());
+        for (const auto& e : entries) {
+            sink.habit(e.id, e.name);
+            e.days.forEach([&](date::Day d) { sink.completion(e.id, d); });
+        }
+        if (records_ > 2 * live_ + kCompactSlack) compact(entries);
+        return true;
+    }
+
+    int addHabit(const std::string& name) override {
+        if (fd_ < 0 || ids_.count(name)) return -1;
+        int id = nextId_++;
+        ids_.emplace(name, id);
+        std::string buf;
+        appendHabit(buf, id, name);
+        append(buf);
+        return id;
+    }
+
+    int findHabitId(const std::string& name) override {
+        auto it = ids_.find(name);
+        return it == ids_.end() ? -1 : it->second;
+    }
+
+    bool setCompletion(int habitId, date::Day day, bool done) override {
+        Record r = makeRecord(static_cast<std::uint32_t>(habitId), day, done ? kSet : kClear);
+        if (inTxn_) { appendRecord(txn_, r); return true; }
+        bool ok;
+        {
+            HABIT_TIMER(kDbStep);
+            ok = writeRecords(reinterpret_cast<const char*>(&r), sizeof r);
+        }
+        compactIfDue();
+        return ok;
+    }
+
+    // a transaction is a buffer written with one write() at commit
+    bool begin() override {
+        inTxn_ = true;
+        return fd_ >= 0;
+    }
+
+    bool commit() override {
+        inTxn_ = false;
+        if (txn_.empty()) return true;
+        bool ok;
+        {
+            HABIT_TIMER(kDbCommit);
+            ok = writeRecords(txn_.data(), txn_.size());
+            txn_.clear();
+        }
+        compactIfDue();
+        return ok;
+    }
+
+    void rollback() override {
+        inTxn_ = false;
+        txn_.clear();
+    }
+
+    std::unique_ptr<Storage> openWriter() override { return nullptr; }   // appends are cheap
+
+    const char* name() const override { return "log"; }
+
+private:
+    struct Entry {
+        int id;
+        std::string name;
+        CompletionBitmap days;
+    };
+
+    int fd_ = -1;
+    std::string path_;
+    std::unordered_map<std::string, int> ids_;   // name -> id, for addHabit/findHabitId
+    int nextId_ = 1;
+    bool inTxn_ = false;
+    std::string txn_;
+    std::size_t records_ = 0;    // records in the file
+    std::size_t live_ = 0;       // of those, live at the last scan
+
+    bool fail(const char* what) {
+        std::cerr << "Log " << path_ << ": cannot " << what << ": " << std::strerror(errno) << "\n";
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void append(const std::string& buf) {
+        if (inTxn_) { txn_ += buf; return; }
+        writeRecords(buf.data(), buf.size());
+        compactIfDue();
+    }
+
+    // Appends whole records. A write that fails part way is cut off again,
+    // since records after a torn one would be dropped by the next scan.
+    bool writeRecords(const char* p, std::size_t n) {
+        off_t end = lseek(fd_, 0, SEEK_END);
+        if (end < 0) return false;
+        if (!writeAll(fd_, p, n)) {
+            if (ftruncate(fd_, end) == 0) lseek(fd_, end, SEEK_SET);
+            return false;
+        }
+        records_ += n / kRecordSize;
+        return true;
+    }
+
+    // the live state, recounting records_ and live_
+    bool scanAll(std::vector<Entry>& entries) {
+        MappedFile map(fd_);
+        if (!map.data()) return false;             // never empty: open() wrote the header
+        scan(map, &entries);
+        records_ = (map.size() - kHeaderSize) / kRecordSize;
+        live_ = 0;
+        for (const auto& e : entries)
+            live_ += 1 + (e.name.size() + kNameChunk - 1) / kNameChunk + e.days.count();
+        return true;
+    }
+
+    // Appends only grow records_; past the threshold the file is rescanned,
+    // which either compacts it or raises live_, so a rescan happens at most
+    // once per doubling of the file.
+    void compactIfDue() {
+        if (records_ <= 2 * live_ + kCompactSlack) return;
+        std::vector<Entry> entries;
+        if (scanAll(entries) && records_ > 2 * live_ + kCompactSlack) compact(entries);
+        // not compacted (the scan or the rewrite failed): look again once
+        // the file has doubled instead of after every write
+        if (records_ > 2 * live_ + kCompactSlack) live_ = records_;
+    }
+
+    // Walk the records, rebuilding the name index (and the entries, if asked
+    // for). Returns the length of the valid prefix: everything after the first
+    // bad checksum, unknown op or unfinished name is treated as torn.
+    std::size_t scan(const MappedFile& map, std::vector<Entry>* entries) {
+        ids_.clear();
+        nextId_ = 1;
+        std::unordered_map<std::uint32_t, std::size_t> slot;    // id -> entries index
+        std::size_t lastSlot = static_cast<std::size_t>(-1);
+        std::uint32_t lastId = 0;
+
+        std::size_t off = kHeaderSize;
+        while (off + kRecordSize <= map.size()) {
+            Record r;
+            std::memcpy(&r, map.data() + off, sizeof r);
+            if (r.check != checksum(r)) break;
+
+            if (r.op == kSet || r.op == kClear) {
+                if (entries) {
+                    if (r.habitId != lastId || lastSlot == static_cast<std::size_t>(-1)) {
+                        auto it = slot.find(r.habitId);
+                        if (it == slot.end()) { off += kRecordSize; continue; }   // unknown habit
+                        lastId = r.habitId;
+                        lastSlot = it->second;
+                    }
+                    CompletionBitmap& days = (*entries)[lastSlot].days;
+                    if (r.op == kSet) days.set(r.day); else days.reset(r.day);
+                }
+                off += kRecordSize;
+            } else if (r.op == kAddHabit) {
+                std::size_t len = static_cast<std::size_t>(r.day);
+                std::size_t chunks = (len + kNameChunk - 1) / kNameChunk;
+                std::size_t end = off + kRecordSize * (1 + chunks);
+                if (r.day < 0 || end > map.size()) break;
+                std::string name(len, '\0');
+                bool whole = true;
+                for (std::size_t c = 0; c < chunks; ++c) {
+                    Record n;
+                    std::memcpy(&n, map.data() + off + kRecordSize * (1 + c), sizeof n);
+                    if (n.op != kName || n.check != checksum(n)) { whole = false; break; }
+                    std::memcpy(&name[c * kNameChunk], &n, std::min(kNameChunk, len - c * kNameChunk));
+                }
+                if (!whole) break;
+
+                int id = static_cast<int>(r.habitId);
+                if (ids_.emplace(name, id).second && entries) {
+                    slot[r.habitId] = entries->size();
+                    entries->push_back(Entry{id, std::move(name), CompletionBitmap()});
+                }
+                if (id >= nextId_) nextId_ = id + 1;
+                off = end;
+            } else {
+                break;    // a stray kName or garbage
+            }
+        }
+        return off;
+    }
+
+    // Rewrite the live state as a fresh log next to the old one, sync it and
+    // rename it into place, so a crash leaves either the old or the new file.
+    // The new file is locked before it gets the log's name and its handle
+    // becomes fd_, so there is no moment when the log is unlocked.
+    void compact(const std::vector<Entry>& entries) {
+        std::string tmp = path_ + ".tmp";
+        int out = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) return;
+        if (flock(out, LOCK_EX | LOCK_NB) != 0) {
+            ::close(out);
+            return;
+        }
+
+        std::string buf(kHeaderSize, '\0');
+        std::memcpy(&buf[0], kMagic, sizeof kMagic);
+        bool ok = true;
+        for (const auto& e : entries) {
+            appendHabit(buf, e.id, e.name);
+            e.days.forEach([&](date::Day d) {
+                appendRecord(buf, makeRecord(static_cast<std::uint32_t>(e.id), d, kSet));
+            });
+            if (buf.size() >= (1u << 20)) {
+                ok = ok && writeAll(out, buf.data(), buf.size());
+                buf.clear();
+            }
+        }
+        ok = ok && writeAll(out, buf.data(), buf.size()) && fdatasync(out) == 0;
+        if (!ok || std::rename(tmp.c_str(), path_.c_str()) != 0) {
+            ::close(out);
+            std::remove(tmp.c_str());
+            return;
+        }
+        ::close(fd_);
+        fd_ = out;                               // at the end, where appends go
+        records_ = live_;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Storage> makeLogStorage() { return std::make_unique<LogStorage>(); }
@@ -0,0 +1,28 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(int fd) { map(fd); }
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    map(fd);
+    ::close(fd);                // the mapping keeps the file alive
+}
+
+MappedFile::~MappedFile() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+}
+
+void MappedFile::map(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) return;
+    void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) return;
+    data_ = static_cast<const char*>(p);
+    size_ = static_cast<std::size_t>(st.st_size);
+    madvise(p, size_, MADV_SEQUENTIAL);
+}
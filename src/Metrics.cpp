@@ -0,0 +1,149 @@
+#include "Metrics.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
+namespace metrics {
+
+namespace {
+
+const char* const kNames[kCount] = {
+    "db_prepare", "db_step", "db_commit", "db_load", "lookup",
+    "streak_query", "streak_rescan", "json_save", "json_load", "frame",
+};
+
+// Written only by the owning thread; atomics so snapshot() can read them
+// from another thread without tearing.
+struct Slot {
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> totalNs{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> buckets[kBuckets] = {};
+};
+
+struct Table {
+    Slot slots[kCount];
+};
+
+void bump(std::atomic<std::uint64_t>& v, std::uint64_t n) {
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void addInto(Table& to, const Table& from) {
+    for (int id = 0; id < kCount; ++id) {
+        Slot& d = to.slots[id];
+        const Slot& s = from.slots[id];
+        bump(d.count, s.count.load(std::memory_order_relaxed));
+        bump(d.totalNs, s.totalNs.load(std::memory_order_relaxed));
+        bump(d.bytes, s.bytes.load(std::memory_order_relaxed));
+        for (int b = 0; b < kBuckets; ++b) bump(d.buckets[b], s.buckets[b].load(std::memory_order_relaxed));
+    }
+}
+
+// Live threads' tables, plus one table holding the sums of every thread that
+// has exited; both guarded by registryMu. Never destroyed: the main thread's
+// LocalTable may run after static destructors on some runtimes.
+std::mutex registryMu;
+std::vector<Table*>& registry() {
+    static auto* tables = new std::vector<Table*>();
+    return *tables;
+}
+Table& retired() {
+    static auto* table = new Table();
+    return *table;
+}
+
+// A thread's table is folded into retired() and freed when the thread
+// exits, so short-lived threads (parallelFor's workers) leave nothing behind.
+struct LocalTable {
+    Table* table = nullptr;
+    ~LocalTable() {
+        if (!table) return;
+        std::lock_guard<std::mutex> lock(registryMu);
+        addInto(retired(), *table);
+        auto& tables = registry();
+        tables.erase(std::find(tables.begin(), tables.end(), table));
+        delete table;
+        table = nullptr;
+    }
+};
+thread_local LocalTable local;
+
+Table& localTable() {
+    if (!local.table) {
+        auto* t = new Table();
+        std::lock_guard<std::mutex> lock(registryMu);
+        registry().push_back(t);
+        local.table = t;
+    }
+    return *local.table;
+}
+
+int bucketOf(std::uint64_t ns) {
+    int b = ns ? 63 - __builtin_clzll(ns) : 0;
+    return b < kBuckets ? b : kBuckets - 1;
+}
+
+double percentile(const std::uint64_t* buckets, std::uint64_t count, double p) {
+    if (!count) return 0.0;
+    std::uint64_t rank = static_cast<std::uint64_t>(p * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return static_cast<double>(std::uint64_t{2} << b);
+    }
+    return static_cast<double>(std::uint64_t{1} << kBuckets);
+}
+
+} // namespace
+
+void record(Id id, std::uint64_t ns, std::uint64_t bytes) {
+    Slot& s = localTable().slots[id];
+    bump(s.count, 1);
+    bump(s.totalNs, ns);
+    if (bytes) bump(s.bytes, bytes);
+    if (ns) bump(s.buckets[bucketOf(ns)], 1);
+}
+
+std::vector<Summary> snapshot() {
+    std::vector<Summary> out;
+    std::lock_guard<std::mutex> lock(registryMu);
+    for (int id = 0; id < kCount; ++id) {
+        std::uint64_t count = 0, totalNs = 0, bytes = 0, timed = 0;
+        std::uint64_t buckets[kBuckets] = {};
+        auto sum = [&](const Table& t) {
+            const Slot& s = t.slots[id];
+            count += s.count.load(std::memory_order_relaxed);
+            totalNs += s.totalNs.load(std::memory_order_relaxed);
+            bytes += s.bytes.load(std::memory_order_relaxed);
+            for (int b = 0; b < kBuckets; ++b) {
+                buckets[b] += s.buckets[b].load(std::memory_order_relaxed);
+                timed += s.buckets[b].load(std::memory_order_relaxed);
+            }
+        };
+        sum(retired());
+        for (const Table* t : registry()) sum(*t);
+        out.push_back(Summary{kNames[id], count, bytes,
+                              timed ? static_cast<double>(totalNs) / static_cast<double>(timed) : 0.0,
+                              percentile(buckets, timed, 0.50), percentile(buckets, timed, 0.99)});
+    }
+    return out;
+}
+
+bool dump(const std::string& path) {
+    nlohmann::json j;
+    j["enabled"] = HABIT_METRICS != 0;
+    j["metrics"] = nlohmann::json::array();
+    for (const auto& s : snapshot()) {
+        if (!s.count) continue;
+        j["metrics"].push_back({{"name", s.name}, {"count", s.count}, {"bytes", s.bytes},
+                                {"mean_ns", s.meanNs}, {"p50_ns", s.p50Ns}, {"p99_ns", s.p99Ns}});
+    }
+    std::ofstream out(path);
+    if (!out) return false;
+    out << j.dump(2) << "\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace metrics
@@ -0,0 +1,108 @@
+#include "Pool.h"
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+
+namespace pool {
+
+namespace {
+
+constexpr std::size_t kMinShift = 4;                   // 16-byte blocks
+constexpr std::size_t kMaxShift = 14;                  // 16 KiB blocks
+constexpr std::size_t kClasses = kMaxShift - kMinShift + 1;
+constexpr std::size_t kSlabBytes = 64u << 10;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// One free list per power-of-two size; fresh blocks come off the current
+// slab, freed ones are pushed back onto the list.
+struct SizeClass {
+    std::mutex mu;
+    FreeBlock* free = nullptr;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+};
+
+// Leaked on purpose: habits held by static objects may be freed after
+// ordinary statics are destroyed.
+SizeClass* classes() {
+    static SizeClass* all = new SizeClass[kClasses];
+    return all;
+}
+
+std::size_t classOf(std::size_t bytes) {
+    if (bytes <= (std::size_t{1} << kMinShift)) return 0;
+    return 64 - static_cast<std::size_t>(__builtin_clzll(bytes - 1)) - kMinShift;
+}
+
+struct Names {
+    std::mutex mu;
+    std::unordered_set<std::string_view> set;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+};
+
+Names& names() {
+    static Names* all = new Names;
+    return *all;
+}
+
+} // namespace
+
+void* allocate(std::size_t bytes) {
+    std::size_t c = classOf(bytes);
+    if (c >= kClasses) return ::operator new(bytes);
+    std::size_t size = std::size_t{1} << (c + kMinShift);
+
+    SizeClass& sc = classes()[c];
+    std::lock_guard<std::mutex> lock(sc.mu);
+    if (FreeBlock* b = sc.free) {
+        sc.free = b->next;
+        return b;
+    }
+    if (static_cast<std::size_t>(sc.limit - sc.cursor) < size) {
+        sc.cursor = static_cast<char*>(::operator new(kSlabBytes));
+        sc.limit = sc.cursor + kSlabBytes;
+    }
+    void* p = sc.cursor;
+    sc.cursor += size;
+    return p;
+}
+
+void deallocate(void* p, std::size_t bytes) noexcept {
+    if (!p) return;
+    std::size_t c = classOf(bytes);
+    if (c >= kClasses) { ::operator delete(p); return; }
+
+    SizeClass& sc = classes()[c];
+    std::lock_guard<std::mutex> lock(sc.mu);
+    FreeBlock* b = static_cast<FreeBlock*>(p);
+    b->next = sc.free;
+    sc.free = b;
+}
+
+std::string_view intern(std::string_view name) {
+    static const char kEmpty[] = "";
+    if (name.empty()) return std::string_view(kEmpty, 0);
+
+    Names& n = names();
+    std::lock_guard<std::mutex> lock(n.mu);
+    auto it = n.set.find(name);
+    if (it != n.set.end()) return *it;
+
+    if (static_cast<std::size_t>(n.limit - n.cursor) < name.size()) {
+        std::size_t size = name.size() > kSlabBytes ? name.size() : kSlabBytes;
+        n.cursor = static_cast<char*>(::operator new(size));
+        n.limit = n.cursor + size;
+    }
+    std::memcpy(n.cursor, name.data(), name.size());
+    std::string_view copy(n.cursor, name.size());
+    n.cursor += name.size();
+    n.set.insert(copy);
+    return copy;
+}
+
+} // namespace pool
@@ -0,0 +1,464 @@
+#include "Storage.h"
+#include "Metrics.h"
+#include <iostream>
+#include <limits>
+#include <sqlite3.h>
+#include <vector>
+
+namespace {
+
+// Change log kept by triggers, so every writer (this app, scripts, the
+// sqlite3 shell) feeds it. seq is the rowid: it only grows, and since pruning
+// removes the oldest rows and never the newest (on open and every
+// kPruneEvery writes), consecutive changes have consecutive seqs. Habit renames and deletes, and completion updates, are
+// logged as kReload. While changes_quiet has a row (only inside a bulk
+// transaction, see setBulk) completion rows are not logged.
+enum ChangeOp { kSet = 1, kClear = 2, kAddHabit = 3, kReload = 4 };
+
+// ----------------- Schema versions -----------------
+
+// Applied in order, each in the transaction that sets PRAGMA user_version to
+// its number. A shipped step is never edited; changes go into a new one.
+struct Migration {
+    int version;
+    const char* sql;
+};
+
+const Migration kMigrations[] = {
+    // 1: the original layout (ISO date text) plus the change log. Files from
+    // before versioning have user_version 0 and some or all of this already.
+    {1,
+     "CREATE TABLE IF NOT EXISTS habits("
+     "id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT UNIQUE);"
+     "CREATE TABLE IF NOT EXISTS completions("
+     "habit_id INTEGER, date TEXT, PRIMARY KEY(habit_id,date));"
+     "CREATE TABLE IF NOT EXISTS changes("
+     "seq INTEGER PRIMARY KEY, habit_id INTEGER, date TEXT, op INTEGER);"
+     "CREATE TABLE IF NOT EXISTS changes_quiet(x INTEGER);"
+     "CREATE TRIGGER IF NOT EXISTS changes_set AFTER INSERT ON completions "
+     "WHEN NOT EXISTS (SELECT 1 FROM changes_quiet) BEGIN "
+     "INSERT INTO changes(habit_id,date,op) VALUES(NEW.habit_id,NEW.date,1); END;"
+     "CREATE TRIGGER IF NOT EXISTS changes_clear AFTER DELETE ON completions "
+     "WHEN NOT EXISTS (SELECT 1 FROM changes_quiet) BEGIN "
+     "INSERT INTO changes(habit_id,date,op) VALUES(OLD.habit_id,OLD.date,2); END;"
+     "CREATE TRIGGER IF NOT EXISTS changes_move AFTER UPDATE ON completions BEGIN "
+     "INSERT INTO changes(habit_id,date,op) VALUES(NEW.habit_id,NULL,4); END;"
+     "CREATE TRIGGER IF NOT EXISTS changes_add AFTER INSERT ON habits BEGIN "
+     "INSERT INTO changes(habit_id,date,op) VALUES(NEW.id,NULL,3); END;"
+     "CREATE TRIGGER IF NOT EXISTS changes_rename AFTER UPDATE ON habits BEGIN "
+     "INSERT INTO changes(habit_id,date,op) VALUES(NEW.id,NULL,4); END;"
+     "CREATE TRIGGER IF NOT EXISTS changes_drop AFTER DELETE ON habits BEGIN "
+     "INSERT INTO changes(habit_id,date,op) VALUES(OLD.id,NULL,4); END;"},
+
+    // 2: days as integers (days since 1970-01-01, date::Day). Completions are
+    // clustered by (habit_id, day) in a WITHOUT ROWID table, so one habit's
+    // history, or any date range of it, is a single contiguous key range and
+    // the primary key covers every query; nothing else needs an index. Plain
+    // rowid ids (no AUTOINCREMENT, no sqlite_sequence updates), and a foreign
+    // key so deleting a habit deletes its completions. Rows whose date does
+    // not parse, or whose habit is gone, are dropped.
+    {2,
+     "DROP TRIGGER changes_set; DROP TRIGGER changes_clear; DROP TRIGGER changes_move;"
+     "DROP TRIGGER changes_add; DROP TRIGGER changes_rename; DROP TRIGGER changes_drop;"
+
+     "CREATE TABLE habits_v2(id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);"
+     "INSERT INTO habits_v2(id,name) SELECT id, name FROM habits WHERE name IS NOT NULL;"
+     "DROP TABLE habits;"
+     "ALTER TABLE habits_v2 RENAME TO habits;"
+
+     "CREATE TABLE completions_v2("
+     "habit_id INTEGER NOT NULL REFERENCES habits(id) ON DELETE CASCADE,"
+     "day INTEGER NOT NULL,"
+     "PRIMARY KEY(habit_id,day)) WITHOUT ROWID;"
+     "INSERT OR IGNORE INTO completions_v2(habit_id,day) "
+     "SELECT habit_id, CAST(julianday(date) - 2440587.5 AS INTEGER) FROM completions "
+     "WHERE julianday(date) IS NOT NULL AND habit_id IN (SELECT id FROM habits) "
+     "ORDER BY 1, 2;"
+     "DROP TABLE completions;"
+     "ALTER TABLE completions_v2 RENAME TO completions;"
+
+     // same seqs, so watchers keep their place; the kReload at the end makes
+     // them reload once
+     "CREATE TABLE changes_v2(seq INTEGER PRIMARY KEY, habit_id INTEGER, day INTEGER, op INTEGER);"
+     "INSERT INTO changes_v2(seq,habit_id,day,op) "
+     "SELECT seq, habit_id, CAST(julianday(date) - 2440587.5 AS INTEGER), op FROM changes;"
+     "DROP TABLE changes;"
+     "ALTER TABLE changes_v2 RENAME TO changes;"
+     "INSERT INTO changes(habit_id,day,op) VALUES(0,NULL,4);"
+
+     "CREATE TRIGGER changes_set AFTER INSERT ON completions "
+     "WHEN NOT EXISTS (SELECT 1 FROM changes_quiet) BEGIN "
+     "INSERT INTO changes(habit_id,day,op) VALUES(NEW.habit_id,NEW.day,1); END;"
+     "CREATE TRIGGER changes_clear AFTER DELETE ON completions "
+     "WHEN NOT EXISTS (SELECT 1 FROM changes_quiet) BEGIN "
+     "INSERT INTO changes(habit_id,day,op) VALUES(OLD.habit_id,OLD.day,2); END;"
+     "CREATE TRIGGER changes_move AFTER UPDATE ON completions BEGIN "
+     "INSERT INTO changes(habit_id,day,op) VALUES(NEW.habit_id,NULL,4); END;"
+     "CREATE TRIGGER changes_add AFTER INSERT ON habits BEGIN "
+     "INSERT INTO changes(habit_id,day,op) VALUES(NEW.id,NULL,3); END;"
+     "CREATE TRIGGER changes_rename AFTER UPDATE ON habits BEGIN "
+     "INSERT INTO changes(habit_id,day,op) VALUES(NEW.id,NULL,4); END;"
+     "CREATE TRIGGER changes_drop AFTER DELETE ON habits BEGIN "
+     "INSERT INTO changes(habit_id,day,op) VALUES(OLD.id,NULL,4); END;"},
+
+    // 3: completions also packed 64 days to a row, the way CompletionBitmap
+    // holds them (word = day >> 6, bit day & 63 of bits), so startup reads a
+    // row per habit and 64 days instead of a row per day. completions stays
+    // the table to write and query; triggers keep the words in step with it
+    // for every writer. A word whose bits reach 0 is deleted.
+    {3,
+     "CREATE TABLE completion_words("
+     "habit_id INTEGER NOT NULL, word INTEGER NOT NULL, bits INTEGER NOT NULL,"
+     "PRIMARY KEY(habit_id,word)) WITHOUT ROWID;"
+     // the bits of a word are distinct, so their sum is their OR
+     "INSERT INTO completion_words(habit_id,word,bits) "
+     "SELECT habit_id, day >> 6, SUM(1 << (day & 63)) FROM completions GROUP BY 1, 2;"
+
+     "CREATE TRIGGER words_set AFTER INSERT ON completions BEGIN "
+     "INSERT INTO completion_words(habit_id,word,bits) "
+     "VALUES(NEW.habit_id, NEW.day >> 6, 1 << (NEW.day & 63)) "
+     "ON CONFLICT(habit_id,word) DO UPDATE SET bits = bits | excluded.bits; END;"
+     "CREATE TRIGGER words_clear AFTER DELETE ON completions BEGIN "
+     "UPDATE completion_words SET bits = bits & ~(1 << (OLD.day & 63)) "
+     "WHERE habit_id = OLD.habit_id AND word = OLD.day >> 6;"
+     "DELETE FROM completion_words WHERE habit_id = OLD.habit_id AND word = OLD.day >> 6 AND bits = 0; END;"
+     "CREATE TRIGGER words_move AFTER UPDATE ON completions BEGIN "
+     "UPDATE completion_words SET bits = bits & ~(1 << (OLD.day & 63)) "
+     "WHERE habit_id = OLD.habit_id AND word = OLD.day >> 6;"
+     "DELETE FROM completion_words WHERE habit_id = OLD.habit_id AND word = OLD.day >> 6 AND bits = 0;"
+     "INSERT INTO completion_words(habit_id,word,bits) "
+     "VALUES(NEW.habit_id, NEW.day >> 6, 1 << (NEW.day & 63)) "
+     "ON CONFLICT(habit_id,word) DO UPDATE SET bits = bits | excluded.bits; END;"},
+};
+
+constexpr int kSchemaVersion = 3;
+
+// changes kept for watchers that fall behind; older ones cost them a reload
+constexpr int kKeepChanges = 100000;
+// writes between prunes, so a long-running process keeps the table bounded
+constexpr int kPruneEvery = kKeepChanges / 10;
+
+// loadAll: zero words bridged inside one run (about 3 years), and the words
+// whose days fit in date::Day
+constexpr std::int64_t kMaxGapWords = 16;
+constexpr std::int64_t kMinWord = std::numeric_limits<date::Day>::min() / 64;
+constexpr std::int64_t kMaxWord = std::numeric_limits<date::Day>::max() / 64 - 1;
+
+class SqliteStorage : public Storage {
+public:
+    ~SqliteStorage() override {
+        for (auto*& s : stmts_) { sqlite3_finalize(s); s = nullptr; }
+        if (db_) sqlite3_close(db_);
+    }
+
+    // open or create the database and bring its schema up to date
+    bool open(const std::string& path) override {
+        if (sqlite3_open(path.c_str(), &db_) != SQLITE_OK) {
+            std::cerr << "Cannot open DB: " << sqlite3_errmsg(db_) << "\n";
+            sqlite3_close(db_);
+            db_ = nullptr;
+            return false;
+        }
+        path_ = path;
+        sqlite3_busy_timeout(db_, 5000);   // a writer handle may hold the lock
+
+        // WAL lets readers run during writes; NORMAL only fsyncs at checkpoints
+        sqlite3_exec(db_, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+        sqlite3_exec(db_, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr);
+
+        if (!migrate()) return false;
+        sqlite3_exec(db_, "PRAGMA foreign_keys=ON;", nullptr, nullptr, nullptr);
+
+        // prepare every statement we reuse, once
+        const char* stmt_sql[kStmtCount] = {
+            "INSERT OR IGNORE INTO habits(name) VALUES(?);",
+            "SELECT id FROM habits WHERE name=?;",
+            "INSERT OR IGNORE INTO completions(habit_id,day) VALUES(?,?);",
+            "DELETE FROM completions WHERE habit_id=? AND day=?;",
+            "PRAGMA data_version;",
+            "SELECT IFNULL(MAX(seq),0) FROM changes;",
+            "SELECT c.seq, c.habit_id, c.op, c.day, h.name FROM changes c "
+            "LEFT JOIN habits h ON h.id = c.habit_id WHERE c.seq > ? ORDER BY c.seq;",
+            "DELETE FROM changes WHERE seq <= (SELECT MAX(seq) FROM changes) - ?;",
+        };
+        for (int i = 0; i < kStmtCount; ++i) {
+            HABIT_TIMER(kDbPrepare);
+            if (sqlite3_prepare_v2(db_, stmt_sql[i], -1, &stmts_[i], nullptr) != SQLITE_OK) {
+                std::cerr << "Cannot prepare statement: " << sqlite3_errmsg(db_) << "\n";
+                return false;
+            }
+        }
+        pruneChanges();
+        externallyChanged();                 // baseline for data_version
+        return true;
+    }
+
+    // One ordered pass over habits LEFT JOIN completion_words: rows arrive
+    // grouped by habit (a habit with no completions yields one row with a
+    // NULL word), in primary key order on both sides, so there is nothing to
+    // sort. A habit's words are handed over in runs: gaps of up to
+    // kMaxGapWords are filled with zeros, a longer one (a stray far-off day
+    // written by some other tool) starts a new run, so the buffer never spans
+    // more than the words actually stored.
+    bool loadAll(Sink& sink) override {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db_, "SELECT COUNT(*) FROM habits;", -1, &stmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_step(stmt) == SQLITE_ROW)
+                sink.reserve(static_cast<std::size_t>(sqlite3_column_int64(stmt, 0)));
+            sqlite3_finalize(stmt);
+        }
+
+        const char* sql =
+            "SELECT h.id, h.name, w.word, w.bits FROM habits h "
+            "LEFT JOIN completion_words w ON w.habit_id = h.id "
+            "ORDER BY h.id, w.word;";
+        if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+        std::vector<std::uint64_t> words;
+        std::int64_t firstWord = 0;
+        bool first = true;
+        int current = 0;
+        auto flushWords = [&] {
+            if (!words.empty())
+                sink.completionWords(current, static_cast<date::Day>(firstWord * 64), words.data(), words.size());
+            words.clear();
+        };
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            int id = sqlite3_column_int(stmt, 0);
+            if (first || id != current) {
+                flushWords();
+                const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+                sink.habit(id, name ? name : "");
+                current = id;
+                first = false;
+            }
+            if (sqlite3_column_type(stmt, 2) == SQLITE_NULL) continue;
+            std::int64_t word = sqlite3_column_int64(stmt, 2);
+            if (word < kMinWord || word > kMaxWord) continue;      // days beyond date::Day
+            if (!words.empty() && word - (firstWord + static_cast<std::int64_t>(words.size())) > kMaxGapWords)
+                flushWords();
+            if (words.empty()) firstWord = word;
+            words.resize(static_cast<std::size_t>(word - firstWord) + 1, 0);
+            words.back() = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 3));
+        }
+        flushWords();
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) {
+            std::cerr << "Cannot load DB: " << sqlite3_errmsg(db_) << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    int addHabit(const std::string& name) override {
+        int id = -1;
+        sqlite3_stmt* s = stmt(kInsertHabit);
+        sqlite3_bind_text(s, 1, name.c_str(), -1, SQLITE_STATIC);
+        HABIT_TIMER(kDbStep);
+        if (sqlite3_step(s) == SQLITE_DONE && sqlite3_changes(db_) > 0)
+            id = static_cast<int>(sqlite3_last_insert_rowid(db_));
+        sqlite3_reset(s);
+        if (id >= 0) noteWrite();
+        return id;
+    }
+
+    int findHabitId(const std::string& name) override {
+        int id = -1;
+        sqlite3_stmt* s = stmt(kSelectHabitId);
+        sqlite3_bind_text(s, 1, name.c_str(), -1, SQLITE_STATIC);
+        HABIT_TIMER(kDbStep);
+        if (sqlite3_step(s) == SQLITE_ROW) id = sqlite3_column_int(s, 0);
+        sqlite3_reset(s);
+        return id;
+    }
+
+    bool setCompletion(int habitId, date::Day day, bool done) override {
+        sqlite3_stmt* s = stmt(done ? kInsertCompletion : kDeleteCompletion);
+        sqlite3_bind_int(s, 1, habitId);
+        sqlite3_bind_int(s, 2, day);
+        HABIT_TIMER(kDbStep);
+        bool ok = sqlite3_step(s) == SQLITE_DONE;
+        sqlite3_reset(s);
+        if (ok) noteWrite();
+        return ok;
+    }
+
+    bool begin() override {
+        if (sqlite3_exec(db_, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) return false;
+        return !bulk_ || sqlite3_exec(db_, "INSERT INTO changes_quiet VALUES(1);", nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+
+    // a bulk transaction is logged as one kReload, so watchers reload once
+    // instead of replaying every row
+    bool commit() override {
+        HABIT_TIMER(kDbCommit);
+        if (bulk_ && sqlite3_exec(db_, "DELETE FROM changes_quiet;"
+                                       "INSERT INTO changes(habit_id,day,op) VALUES(0,NULL,4);",
+                                  nullptr, nullptr, nullptr) != SQLITE_OK)
+            return false;
+        if (sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) return false;
+        noteWrite();
+        return true;
+    }
+
+    // a no-op (an error, ignored) when no transaction is open
+    void rollback() override { sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr); }
+
+    void setBulk(bool on) override { bulk_ = on; }
+
+    std::unique_ptr<Storage> openWriter() override {
+        auto writer = std::make_unique<SqliteStorage>();
+        if (!writer->open(path_)) return nullptr;
+        return writer;
+    }
+
+    const char* name() const override { return "sqlite"; }
+
+    // ----------------- Change feed -----------------
+
+    std::string watchPath() const override { return path_; }
+
+    // data_version moves only when another connection commits; reading it
+    // is a check of the WAL index, no table access
+    bool externallyChanged() override {
+        sqlite3_stmt* s = stmt(kDataVersion);
+        bool changed = false;
+        if (sqlite3_step(s) == SQLITE_ROW) {
+            std::int64_t v = sqlite3_column_int64(s, 0);
+            changed = v != dataVersion_;
+            dataVersion_ = v;
+        }
+        sqlite3_reset(s);
+        return changed;
+    }
+
+    std::int64_t changeCursor() override {
+        sqlite3_stmt* s = stmt(kMaxSeq);
+        std::int64_t seq = sqlite3_step(s) == SQLITE_ROW ? sqlite3_column_int64(s, 0) : 0;
+        sqlite3_reset(s);
+        return seq;
+    }
+
+    // One statement, so one read snapshot. The first row has to be
+    // cursor + 1; anything later means the rows in between were pruned.
+    bool readChanges(std::int64_t& cursor, ChangeSink& sink) override {
+        sqlite3_stmt* s = stmt(kChangesSince);
+        sqlite3_bind_int64(s, 1, cursor);
+        bool ok = true;
+        HABIT_TIMER(kDbStep);
+        while (ok && sqlite3_step(s) == SQLITE_ROW) {
+            std::int64_t seq = sqlite3_column_int64(s, 0);
+            int id = sqlite3_column_int(s, 1);
+            int op = sqlite3_column_int(s, 2);
+            if (seq != cursor + 1 || op == kReload) { ok = false; break; }
+            cursor = seq;
+            if (op == kAddHabit) {
+                const char* name = reinterpret_cast<const char*>(sqlite3_column_text(s, 4));
+                if (name) sink.habit(id, name);       // NULL: deleted since, a later kReload follows
+                continue;
+            }
+            if (sqlite3_column_type(s, 3) != SQLITE_NULL)
+                sink.completion(id, sqlite3_column_int(s, 3), op == kSet);
+        }
+        sqlite3_reset(s);
+        return ok;
+    }
+
+private:
+    // Runs the steps past the file's user_version. An up-to-date file takes
+    // no lock; otherwise the version is read again under BEGIN IMMEDIATE, so
+    // when two processes open an old file only the first migrates it. A file
+    // that had data is vacuumed afterwards to hand back the pages of the
+    // replaced tables.
+    bool migrate() {
+        int version = queryInt("PRAGMA user_version;");
+        if (version == kSchemaVersion) return true;
+        if (sqlite3_exec(db_, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "Cannot lock DB: " << sqlite3_errmsg(db_) << "\n";
+            return false;
+        }
+        version = queryInt("PRAGMA user_version;");
+        bool hadData = queryInt("SELECT COUNT(*) FROM sqlite_master;") > 0;
+        if (version >= kSchemaVersion) {
+            sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+            if (version == kSchemaVersion) return true;         // migrated by another process
+            std::cerr << "DB schema version " << version << " is newer than this build ("
+                      << kSchemaVersion << ")\n";
+            return false;
+        }
+
+        for (const Migration& m : kMigrations) {
+            if (m.version <= version) continue;
+            std::string sql = std::string(m.sql) + "PRAGMA user_version=" + std::to_string(m.version) + ";";
+            char* err = nullptr;
+            if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+                std::cerr << "Cannot migrate DB to schema version " << m.version << ": "
+                          << (err ? err : "unknown error") << "\n";
+                sqlite3_free(err);
+                sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+                return false;
+            }
+        }
+        if (sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "Cannot migrate DB: " << sqlite3_errmsg(db_) << "\n";
+            sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+        if (hadData) {
+            sqlite3_exec(db_, "VACUUM;", nullptr, nullptr, nullptr);
+            std::cout << "Upgraded DB schema from version " << version << " to " << kSchemaVersion << "\n";
+        }
+        return true;
+    }
+
+    // Counts logged writes and prunes once kPruneEvery have piled up, but
+    // only between transactions: an open one may still roll back.
+    void noteWrite() {
+        if (++writes_ < kPruneEvery || !sqlite3_get_autocommit(db_)) return;
+        pruneChanges();
+    }
+
+    // drops all but the newest kKeepChanges rows; other connections' writes
+    // count too, since the cutoff is taken from MAX(seq)
+    void pruneChanges() {
+        sqlite3_stmt* s = stmt(kPruneChanges);
+        sqlite3_bind_int(s, 1, kKeepChanges);
+        HABIT_TIMER(kDbStep);
+        sqlite3_step(s);
+        sqlite3_reset(s);
+        writes_ = 0;
+    }
+
+    int queryInt(const char* sql) {
+        sqlite3_stmt* s;
+        int v = 0;
+        if (sqlite3_prepare_v2(db_, sql, -1, &s, nullptr) != SQLITE_OK) return 0;
+        if (sqlite3_step(s) == SQLITE_ROW) v = sqlite3_column_int(s, 0);
+        sqlite3_finalize(s);
+        return v;
+    }
+
+    sqlite3* db_ = nullptr;
+    std::string path_;
+    std::int64_t dataVersion_ = -1;
+    bool bulk_ = false;
+    int writes_ = 0;                     // since the last prune
+
+    enum Stmt {
+        kInsertHabit, kSelectHabitId, kInsertCompletion, kDeleteCompletion,
+        kDataVersion, kMaxSeq, kChangesSince, kPruneChanges, kStmtCount
+    };
+    sqlite3_stmt* stmts_[kStmtCount] = {};
+
+    // cached statement, reset and ready for new bindings
+    sqlite3_stmt* stmt(Stmt which) {
+        sqlite3_stmt* s = stmts_[which];
+        sqlite3_reset(s);
+        sqlite3_clear_bindings(s);
+        return s;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Storage> makeSqliteStorage() { return std::make_unique<SqliteStorage>(); }
@@ -1,37 +1,119 @@
+#include "Cli.h"
 #include "HabitManager.h"
+#include "Metrics.h"
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/terminal.hpp>
 #include <algorithm>   // std::max, std::min
 #include <chrono>
-#include <ctime>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 using namespace ftxui;
 
-static const char* kDBFile = "habits.db";  // SQLite DB file
+static const char* kDBFile = "habits.db";    // SQLite DB file
+static const char* kLogFile = "habits.log";  // --storage log: append-only event log
 
-// Return ISO date for (today - days_back), e.g. "2025-10-05"
-std::string iso_days_back(int days_back) {
-    auto now = std::chrono::system_clock::now() - std::chrono::hours(24 * days_back);
-    std::time_t tt = std::chrono::system_clock::to_time_t(now);
-    std::tm tm = *std::localtime(&tt);
-    char buf[11];
-    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
-    return std::string(buf);
+// --synthetic N: N in-memory habits with a year of random history, no DB.
+// Used to measure frame time on large lists.
+static void fill_synthetic(HabitManager& manager, int count) {
+    std::mt19937 rng(42);
+    date::Day today = date::today();
+    std::vector<Habit> habits;
+    habits.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Habit h("habit " + std::to_string(i));
+        for (date::Day d = today - 365; d <= today; ++d)
+            if (rng() % 10 < 6) h.setCompletedOn(d, true);
+        habits.push_back(std::move(h));
+    }
+    manager.addHabits(std::move(habits));
 }
 
-int main() {
+// A cached Element plus what it was built from; rebuilt only when the
+// habit's revision, the day or the manager's generation changes.
+struct CachedRow {
+    Element element;
+    std::uint32_t revision = 0;
+    std::uint32_t generation = 0;
+    date::Day day = 0;
+    bool valid = false;
+
+    bool fresh(const Habit& h, std::uint32_t gen, date::Day today) const {
+        return valid && revision == h.revision() && generation == gen && day == today;
+    }
+    void store(Element e, const Habit& h, std::uint32_t gen, date::Day today) {
+        element = std::move(e);
+        revision = h.revision();
+        generation = gen;
+        day = today;
+        valid = true;
+    }
+};
+
+int main(int argc, char** argv) {
+    // headless command mode (habit_tracker mark --habit X ...): no UI at all
+    if (argc > 1 && cli::isCommand(argv[1])) {
+        std::ios::sync_with_stdio(false);
+        return cli::run(std::vector<std::string>(argv + 1, argv + argc), std::cin, std::cout);
+    }
+
     HabitManager manager;
-    // open database and load habits
-    manager.openDB(kDBFile);
-    manager.loadFromDB(); // fills vector from DB
+    int synthetic = 0;
+    std::string metrics_path;   // --metrics FILE: dump hot-path stats at exit
+    Backend backend = Backend::Sqlite;
+    const char* import_path = nullptr;   // --import FILE: merge a JSON/CSV history before the UI starts
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--synthetic") == 0) synthetic = std::atoi(argv[i + 1]);
+        if (std::strcmp(argv[i], "--metrics") == 0) metrics_path = argv[i + 1];
+        if (std::strcmp(argv[i], "--storage") == 0 && std::strcmp(argv[i + 1], "log") == 0)
+            backend = Backend::Log;
+        if (std::strcmp(argv[i], "--import") == 0) import_path = argv[i + 1];
+    }
+
+    if (synthetic > 0) {
+        fill_synthetic(manager, synthetic);
+    } else {
+        // open database and load habits
+        manager.openDB(backend == Backend::Log ? kLogFile : kDBFile, backend);
+        manager.loadFromDB(); // fills vector from DB
+        if (import_path) {
+            ImportOptions opts;
+            opts.onProgress = [](const ImportProgress& p) {
+                std::fprintf(stderr, "\rimporting: %.0f / %.0f MB, %llu rows, %.1f MB/s ",
+                             p.bytesDone / 1e6, p.bytesTotal / 1e6,
+                             static_cast<unsigned long long>(p.rows),
+                             p.seconds > 0 ? p.bytesDone / 1e6 / p.seconds : 0.0);
+            };
+            manager.importFile(import_path, opts);
+            std::fprintf(stderr, "\n");
+        }
+        manager.startAsyncWriter();   // toggles are written off the UI thread (SQLite only)
+    }
 
     // -------- UI State ----------
     int selected = 0;           // which habit row is highlighted
+    int scroll_top = 0;         // first habit row inside the viewport
+    int day_cursor = 6;         // column in the 7-day panel (6 = today)
     bool adding = false;        // are we entering a new habit name?
     std::string new_name;       // input buffer for the new habit
 
+    HabitManager::Reader reader(manager);   // UI thread's view of the habits
+
+    // -------- Render caches ----------
+    std::vector<CachedRow> row_cache;   // one per habit, built lazily
+    CachedRow weekly_cache;             // 7-day panel for weekly_for
+    int weekly_for = -1;
+    int weekly_day = -1;                // day_cursor it was built with
+    long long frame_us = 0;             // time to build the last frame
+
     // Input & button used when `adding == true`
     auto input = Input(&new_name, "new habit name");
     auto add_button = Button("Add", [&] {
@@ -43,28 +125,45 @@ int main() {
     });
     auto add_row = Container::Horizontal({input, add_button});
 
-    // Main renderer: draw left list, right 7-day view, and footer
+    // Main renderer: draw left list, right 7-day view, and footer.
+    // Only rows inside the viewport are visited, and their Elements are
+    // reused until that habit changes.
     auto renderer = Renderer(add_row, [&] {
-        const std::vector<Habit>& habits = manager.getHabits();
-        std::string today = iso_days_back(0);
+        HABIT_TIMER(kFrame);
+        auto frame_start = std::chrono::steady_clock::now();
+        const HabitSnapshot& habits = reader.get();   // one consistent version per frame
+        date::Day today = date::today();   // one lookup per frame
+        std::uint32_t gen = habits.generation();
+        int count = (int)habits.size();
 
         // Keep selection in range
         if (habits.empty()) selected = 0;
         if (!habits.empty()) {
-            if (selected >= (int)habits.size()) selected = (int)habits.size() - 1;
+            if (selected >= count) selected = count - 1;
             if (selected < 0) selected = 0;
         }
 
+        // Viewport: window borders, separator and footer take 4 lines
+        int visible = std::max(1, Terminal::Size().dimy - 4);
+        if (selected < scroll_top) scroll_top = selected;
+        if (selected >= scroll_top + visible) scroll_top = selected - visible + 1;
+        scroll_top = std::max(0, std::min(scroll_top, std::max(0, count - visible)));
+        if ((int)row_cache.size() != count) row_cache.resize(count);
+
         // LEFT: habit list with [✔]/[ ] today and streak
         Elements list_rows;
-        for (int i = 0; i < (int)habits.size(); ++i) {
+        int end = std::min(count, scroll_top + visible);
+        for (int i = scroll_top; i < end; ++i) {
             const auto& h = habits[i];
-            bool done_today = h.isCompletedOn(today);
+            auto& cached = row_cache[i];
+            if (!cached.fresh(h, gen, today)) {
+                auto box = text(h.isCompletedOn(today) ? "[✔]" : "[ ]");
+                auto name = text(std::string(" ").append(h.getName()));
+                auto streak = text("  (streak: " + std::to_string(h.currentStreak(today)) + ")");
+                cached.store(hbox({box, name, streak}), h, gen, today);
+            }
             auto sel_mark = text(i == selected ? "▶ " : "  ");
-            auto box = text(done_today ? "[✔]" : "[ ]");
-            auto name = text(" " + h.getName());
-            auto streak = text("  (streak: " + std::to_string(h.currentStreak()) + ")");
-            list_rows.push_back(hbox({sel_mark, box, name, streak}));
+            list_rows.push_back(hbox({sel_mark, cached.element}));
         }
         auto left_panel = window(text(" Habits "),
                                  vbox(std::move(list_rows)) |
@@ -74,13 +173,26 @@ int main() {
         Element right_panel;
         if (!habits.empty()) {
             const auto& h = habits[selected];
-            Elements days;
-            for (int i = 6; i >= 0; --i) {
-                bool done = h.isCompletedOn(iso_days_back(i));
-                days.push_back(text(done ? "✔" : "✘") | center | size(WIDTH, EQUAL, 3));
+            if (weekly_for != selected || weekly_day != day_cursor || !weekly_cache.fresh(h, gen, today)) {
+                std::uint64_t week = h.completions().window(today - 6, 7);
+                Elements days;
+                for (int i = 0; i < 7; ++i) {
+                    bool done = (week >> i) & 1u;
+                    auto cell = text(done ? "✔" : "✘") | center | size(WIDTH, EQUAL, 3);
+                    days.push_back(i == day_cursor ? cell | inverted : cell);
+                }
+                HabitStats month = habitStats(h, today - 29, today);
+                auto summary = text("30 days: " + std::to_string(month.completed) + "/30 (" +
+                                    std::to_string((int)(month.rate * 100 + 0.5)) + "%)  best streak: " +
+                                    std::to_string(month.longestStreak));
+                auto title = text(std::string(" Weekly (last 7 days) for: ").append(h.getName()));
+                weekly_cache.store(window(title, vbox({hbox(std::move(days)) | size(HEIGHT, EQUAL, 3),
+                                                       summary})),
+                                   h, gen, today);
+                weekly_for = selected;
+                weekly_day = day_cursor;
             }
-            auto title = text(" Weekly (last 7 days) for: " + h.getName());
-            right_panel = window(title, hbox(std::move(days)) | size(HEIGHT, EQUAL, 3));
+            right_panel = weekly_cache.element;
         } else {
             right_panel = window(text(" Weekly "), text("No habits"));
         }
@@ -95,8 +207,12 @@ int main() {
                 add_button->Render()
             });
         } else {
-            footer = text("Keys: ↑/↓ move  | Space toggle today | a add  | q quit");
+            std::string help = "Keys: ↑/↓ PgUp/PgDn move  | ←/→ day  | Space toggle day  | w fill week  | a add  | q quit";
+            if (synthetic > 0) help += "  | frame: " + std::to_string(frame_us) + "us";
+            footer = text(help);
         }
+        frame_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - frame_start).count();
 
         // Layout: two columns + footer
         return vbox({
@@ -112,7 +228,7 @@ int main() {
 
     // Keyboard handling: arrows, toggle, add/quit
     auto app = CatchEvent(renderer, [&](Event e) {
-        const auto& habits = manager.getHabits();
+        const HabitSnapshot& habits = reader.get();
         bool has = !habits.empty();
 
         // When adding, route keys to the input/button first
@@ -140,18 +256,40 @@ int main() {
 
         if (e == Event::ArrowUp && has)  { selected = std::max(0, selected - 1); return true; }
         if (e == Event::ArrowDown && has){ selected = std::min((int)habits.size() - 1, selected + 1); return true; }
+        int page = std::max(1, Terminal::Size().dimy - 4);
+        if (e == Event::PageUp && has)   { selected = std::max(0, selected - page); return true; }
+        if (e == Event::PageDown && has) { selected = std::min((int)habits.size() - 1, selected + page); return true; }
+
+        if (e == Event::ArrowLeft && has)  { day_cursor = std::max(0, day_cursor - 1); return true; }
+        if (e == Event::ArrowRight && has) { day_cursor = std::min(6, day_cursor + 1); return true; }
 
         if (e == Event::Character(' ') && has) {
-            // Toggle today's completion for the selected habit
-            bool done = habits[selected].isCompletedOn(iso_days_back(0));
-            manager.setToday(habits[selected].getName(), !done);
+            // Toggle the highlighted day for the selected habit
+            date::Day day = date::today() - 6 + day_cursor;
+            bool done = habits[selected].isCompletedOn(day);
+            manager.setCompletedOn(habits.handle(selected), day, !done);
+            return true;
+        }
+        if (e == Event::Character('w') && has) {
+            // Backfill the whole week, or clear it if it is already full
+            date::Day today = date::today();
+            bool full = habits[selected].completions().count(today - 6, today) == 7;
+            manager.setCompletedRange(habits.handle(selected), today - 6, today, !full);
             return true;
         }
         return false;
     });
 
-    // Run the app full-screen
+    // Run the app full-screen; writes from other processes (cron jobs,
+    // scripts) show up on the next frame
     auto screen = ScreenInteractive::Fullscreen();
+    if (synthetic == 0) manager.startWatching([&screen] { screen.PostEvent(Event::Custom); });
     screen.Loop(app);
+    manager.stopWatching();
+
+    if (!metrics_path.empty()) {
+        manager.flush();            // include pending commits in the dump
+        metrics::dump(metrics_path);
+    }
     return 0;
 }